@@ -0,0 +1,203 @@
+#include "ED_SNTP_race.h"
+
+#include <esp_log.h>
+#include <esp_random.h>
+#include <esp_timer.h>
+#include <lwip/netdb.h>
+#include <lwip/sockets.h>
+#include <cstdlib>
+#include <cstring>
+
+namespace ED_SNTP {
+
+static const char *TAG = "ED_SNTP_race";
+
+#define NTP_PORT           123
+#define NTP_PACKET_LEN     48
+#define NTP_UNIX_OFFSET    2208988800LL   // 1900-01-01 to 1970-01-01, seconds
+#define NTP_VERSION        4
+#define NTP_MODE_CLIENT    3
+#define NTP_MODE_SERVER    4
+#define NTP_LI_ALARM       3              // leap indicator: server clock not synchronized
+#define NTP_HOST_MAX       64
+
+struct RaceSlot {
+  struct sockaddr_in addr;
+  uint64_t nonce;      // our transmit timestamp, echoed as originate timestamp
+  int64_t sent_us;
+  uint32_t rtt_us;
+  bool tried;          // name lookup started
+  bool sent;
+  bool answered;
+  bool valid;
+};
+
+static uint64_t rd64(const uint8_t *p) {
+  uint64_t v = 0;
+  for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+  return v;
+}
+
+static void wr64(uint8_t *p, uint64_t v) {
+  for (int i = 7; i >= 0; i--, v >>= 8) p[i] = (uint8_t)v;
+}
+
+// NTP timestamps wrap in 2036: a seconds field with the top bit clear is
+// taken as era 1, which keeps 1968-2104 unambiguous
+static int64_t ntpToUnix_us(uint64_t ts) {
+  uint32_t sec = (uint32_t)(ts >> 32);
+  int64_t s = (int64_t)sec - NTP_UNIX_OFFSET + ((sec & 0x80000000u) ? 0 : 0x100000000LL);
+  return s * 1000000 + (int64_t)(((ts & 0xFFFFFFFFu) * 1000000) >> 32);
+}
+
+// Resolves "host[:port]" and sends the request; false if it never left
+static bool sendQuery(int sock, const char *server, RaceSlot *slot) {
+  slot->tried = true;
+  char host[NTP_HOST_MAX];
+  uint16_t port = NTP_PORT;
+  const char *colon = strchr(server, ':');
+  size_t n = colon ? (size_t)(colon - server) : strlen(server);
+  if (n == 0 || n >= sizeof(host)) return false;
+  memcpy(host, server, n);
+  host[n] = '\0';
+  if (colon) port = (uint16_t)atoi(colon + 1);
+
+  struct addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  struct addrinfo *res = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &res) != 0 || !res) {
+    ESP_LOGW(TAG, "Cannot resolve %s", host);
+    return false;
+  }
+  memcpy(&slot->addr, res->ai_addr, sizeof(slot->addr));
+  freeaddrinfo(res);
+  slot->addr.sin_port = htons(port);
+
+  uint8_t pkt[NTP_PACKET_LEN] = {};
+  pkt[0] = (NTP_VERSION << 3) | NTP_MODE_CLIENT;
+  slot->nonce = ((uint64_t)esp_random() << 32) | esp_random();
+  wr64(pkt + 40, slot->nonce);
+  slot->sent_us = esp_timer_get_time();
+  if (sendto(sock, pkt, sizeof(pkt), 0, (struct sockaddr *)&slot->addr, sizeof(slot->addr)) != sizeof(pkt)) {
+    ESP_LOGW(TAG, "Send to %s failed, errno %d", server, errno);
+    return false;
+  }
+  slot->sent = true;
+  return true;
+}
+
+// Matches a reply to its slot and checks it; fills `r` if it is usable
+static bool parseReply(const uint8_t *pkt, const struct sockaddr_in &from, int64_t rx_us, RaceSlot *slots,
+                       size_t count, NtpReply *r) {
+  for (size_t i = 0; i < count; i++) {
+    RaceSlot &s = slots[i];
+    if (!s.sent || s.answered || s.addr.sin_addr.s_addr != from.sin_addr.s_addr || s.addr.sin_port != from.sin_port)
+      continue;
+    if (rd64(pkt + 24) != s.nonce) continue;   // not an answer to this request
+    s.answered = true;
+
+    uint8_t li = pkt[0] >> 6, mode = pkt[0] & 7, stratum = pkt[1];
+    uint64_t rx = rd64(pkt + 32), tx = rd64(pkt + 40);
+    if (mode != NTP_MODE_SERVER || li == NTP_LI_ALARM || stratum == 0 || stratum > 15 || tx == 0) {
+      ESP_LOGW(TAG, "Server %u: unusable reply (mode %u, LI %u, stratum %u)", (unsigned)i, mode, li, stratum);
+      return false;
+    }
+    int64_t t2 = ntpToUnix_us(rx), t3 = ntpToUnix_us(tx);
+    int64_t rtt = (rx_us - s.sent_us) - (t3 - t2);
+    if (rtt < 0) rtt = 0;
+    r->unixTime_us = t3 + rtt / 2;
+    r->rtc_us = (uint64_t)rx_us;
+    r->rtt_us = (uint32_t)rtt;
+    r->server = (int8_t)i;
+    r->stratum = stratum;
+    s.rtt_us = (uint32_t)rtt;
+    s.valid = true;
+    return true;
+  }
+  return false;
+}
+
+// Waits up to `wait_us` for replies and drains them; true once the race is decided
+static bool collect(int sock, RaceSlot *slots, size_t count, RacePolicy policy, int64_t wait_us, NtpReply *out) {
+  fd_set rd;
+  FD_ZERO(&rd);
+  FD_SET(sock, &rd);
+  struct timeval tv = {(time_t)(wait_us / 1000000), (suseconds_t)(wait_us % 1000000)};
+  if (select(sock + 1, &rd, nullptr, nullptr, &tv) <= 0) return false;
+
+  uint8_t pkt[NTP_PACKET_LEN];
+  struct sockaddr_in from;
+  socklen_t fromLen = sizeof(from);
+  int len;
+  while ((len = recvfrom(sock, pkt, sizeof(pkt), MSG_DONTWAIT, (struct sockaddr *)&from, &fromLen)) >= 0) {
+    int64_t rx_us = esp_timer_get_time();
+    fromLen = sizeof(from);
+    NtpReply r;
+    if (len < NTP_PACKET_LEN || !parseReply(pkt, from, rx_us, slots, count, &r)) continue;
+    uint8_t replies = out->replies + 1;
+    if (out->server < 0 || r.rtt_us < out->rtt_us) *out = r;
+    out->replies = replies;
+    if (policy == RacePolicy::FIRST_VALID) return true;
+  }
+  return false;
+}
+
+esp_err_t ntpRace(const char *const *servers, size_t count, RacePolicy policy, uint32_t timeout_ms,
+                  NtpReply *out, uint32_t *rtt_us) {
+  if (!servers || !out || count == 0 || count > NTP_RACE_MAX_SERVERS) return ESP_ERR_INVALID_ARG;
+  *out = NtpReply();
+  out->server = -1;
+  for (size_t i = 0; rtt_us && i < count; i++) rtt_us[i] = NTP_RACE_CANCELLED;
+
+  int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock < 0) {
+    ESP_LOGE(TAG, "socket() failed, errno %d", errno);
+    return ESP_FAIL;
+  }
+
+  RaceSlot slots[NTP_RACE_MAX_SERVERS] = {};
+  int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+  size_t sent = 0;
+  bool done = false;
+  bool expired = false;
+  for (size_t i = 0; i < count && !done; i++) {
+    if (sendQuery(sock, servers[i], &slots[i])) sent++;
+    done = collect(sock, slots, count, policy, 0, out);   // a reply may already be in
+  }
+  while (!done && sent > 0) {
+    // BEST_RTT: once a reply is in, a pending server can only beat it by
+    // answering within the best round trip after its own request left
+    int64_t until = out->server >= 0 ? 0 : deadline;
+    size_t pending = 0;
+    for (size_t i = 0; i < count; i++) {
+      if (!slots[i].sent || slots[i].answered) continue;
+      pending++;
+      if (out->server >= 0 && slots[i].sent_us + out->rtt_us > until) until = slots[i].sent_us + out->rtt_us;
+    }
+    if (pending == 0) break;
+    if (until > deadline) until = deadline;
+    int64_t left = until - esp_timer_get_time();
+    if (left <= 0) {
+      expired = until == deadline;
+      break;
+    }
+    done = collect(sock, slots, count, policy, left, out);
+  }
+  close(sock);
+
+  // A server still pending failed only if it had the whole timeout
+  for (size_t i = 0; rtt_us && i < count; i++) {
+    const RaceSlot &s = slots[i];
+    if (s.valid) rtt_us[i] = s.rtt_us;
+    else if (!s.tried || (s.sent && !s.answered && !expired)) rtt_us[i] = NTP_RACE_CANCELLED;
+    else rtt_us[i] = NTP_RACE_FAILED;
+  }
+
+  if (out->server < 0) return sent == 0 ? ESP_ERR_NOT_FOUND : ESP_ERR_TIMEOUT;
+  ESP_LOGD(TAG, "%s won: rtt %lu us, stratum %u, %u valid replies", servers[out->server],
+           (unsigned long)out->rtt_us, out->stratum, out->replies);
+  return ESP_OK;
+}
+
+} // namespace ED_SNTP
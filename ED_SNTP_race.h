@@ -0,0 +1,50 @@
+#pragma once
+
+// #region StdManifest
+/**
+ * @file ED_SNTP_race.h
+ * @brief Queries several NTP servers at once and keeps the first valid, or
+ * the closest, answer.
+ *
+ * One UDP socket carries a client request to every server. Each request
+ * carries a random transmit timestamp that the server echoes back as the
+ * originate timestamp, so a reply is matched to its request and stale or
+ * forged packets are dropped. Closing the socket cancels the servers still
+ * pending: their replies have nowhere to land.
+ */
+// #endregion
+
+#include <esp_err.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ED_SNTP {
+
+#define NTP_RACE_MAX_SERVERS   8
+#define NTP_RACE_FAILED        UINT32_MAX         // rtt_us[]: no valid reply in the time given
+#define NTP_RACE_CANCELLED     (UINT32_MAX - 1)   // rtt_us[]: race decided before it could answer
+
+enum class RacePolicy {
+  FIRST_VALID,   // stop at the first valid reply
+  BEST_RTT       // wait for every server (or the timeout), keep the shortest round trip
+};
+
+struct NtpReply {
+  int64_t unixTime_us;   // server time at rtc_us: transmit time + half the path delay
+  uint64_t rtc_us;       // esp_timer when the reply arrived
+  uint32_t rtt_us;       // round trip minus the server's own processing time
+  int8_t server;         // index in the list raced, -1 = none
+  uint8_t stratum;
+  uint8_t replies;       // valid replies received before the race ended
+};
+
+// `servers` are host names or IPv4 literals, optionally "host:port". Names
+// are resolved one after the other and each request leaves as soon as its
+// name resolves, so a fast server can win before a slow name resolves.
+// `rtt_us`, if given, gets each server's outcome: its round trip, or
+// NTP_RACE_FAILED / NTP_RACE_CANCELLED.
+// ESP_ERR_NOT_FOUND: no name resolved; ESP_ERR_TIMEOUT: no valid reply.
+esp_err_t ntpRace(const char *const *servers, size_t count, RacePolicy policy, uint32_t timeout_ms,
+                  NtpReply *out, uint32_t *rtt_us = nullptr);
+
+} // namespace ED_SNTP
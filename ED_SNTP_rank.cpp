@@ -0,0 +1,178 @@
+#include "ED_SNTP_rank.h"
+
+#include <esp_log.h>
+#include <nvs.h>
+#include <cstddef>
+#include <cstring>
+#include "sdkconfig.h"
+
+namespace ED_SNTP {
+
+#if CONFIG_ED_SNTP_SERVER_RANKING
+static const char *TAG = "ED_SNTP_rank";
+#endif
+
+#define RANK_NVS_NAMESPACE   "ed_sntp"
+#define RANK_NVS_KEY         "rank"
+#define RANK_VERSION         1
+#define RANK_SMOOTHING       4      // each sync moves latency and success rate by 1/4
+
+// FNV-1a; 0 is kept for "no record"
+static uint32_t nameHash(const char *s) {
+  uint32_t h = 2166136261u;
+  while (*s) h = (h ^ (uint8_t)*s++) * 16777619u;
+  return h ? h : 1;
+}
+
+// NVS blob: a header and the entries that have a record
+struct ServerRanking::Stored {
+  uint8_t version;
+  uint8_t count;
+  Entry entries[SNTP_RANK_MAX_SERVERS];
+};
+
+ServerRanking::ServerRanking()
+    : m_entries(), m_servers(nullptr), m_count(0), m_enabled(false), m_lock(portMUX_INITIALIZER_UNLOCKED) {}
+
+void ServerRanking::load(const char *const *servers, size_t count) {
+  if (count > SNTP_RANK_MAX_SERVERS) count = SNTP_RANK_MAX_SERVERS;
+  Entry entries[SNTP_RANK_MAX_SERVERS] = {};
+  bool enabled = false;
+
+#if CONFIG_ED_SNTP_SERVER_RANKING
+  enabled = true;
+  Stored stored = {};
+  size_t len = sizeof(stored);
+  nvs_handle_t h;
+  esp_err_t err = nvs_open(RANK_NVS_NAMESPACE, NVS_READONLY, &h);
+  if (err == ESP_OK) {
+    err = nvs_get_blob(h, RANK_NVS_KEY, &stored, &len);
+    nvs_close(h);
+  }
+  if (err == ESP_OK && stored.version == RANK_VERSION && stored.count <= SNTP_RANK_MAX_SERVERS) {
+    for (size_t i = 0; i < count; i++) {
+      uint32_t hash = nameHash(servers[i]);
+      for (size_t k = 0; k < stored.count; k++) {
+        if (stored.entries[k].nameHash == hash) entries[i] = stored.entries[k];
+      }
+    }
+  } else if (err != ESP_ERR_NVS_NOT_FOUND) {
+    ESP_LOGW(TAG, "No stored ranking (%s)", esp_err_to_name(err));
+  }
+#endif
+
+  portENTER_CRITICAL(&m_lock);
+  memcpy(m_entries, entries, sizeof(m_entries));
+  m_servers = servers;
+  m_count = count;
+  m_enabled = enabled;
+  portEXIT_CRITICAL(&m_lock);
+}
+
+esp_err_t ServerRanking::save() {
+#if CONFIG_ED_SNTP_SERVER_RANKING
+  Stored stored = {};
+  stored.version = RANK_VERSION;
+  portENTER_CRITICAL(&m_lock);
+  bool enabled = m_enabled;
+  for (size_t i = 0; i < m_count; i++) {
+    if (m_entries[i].nameHash) stored.entries[stored.count++] = m_entries[i];
+  }
+  portEXIT_CRITICAL(&m_lock);
+  if (!enabled) return ESP_ERR_INVALID_STATE;
+
+  // Flash writes stay outside the lock; only the used entries are stored
+  nvs_handle_t h;
+  esp_err_t err = nvs_open(RANK_NVS_NAMESPACE, NVS_READWRITE, &h);
+  if (err == ESP_OK) {
+    err = nvs_set_blob(h, RANK_NVS_KEY, &stored, offsetof(Stored, entries) + stored.count * sizeof(Entry));
+    if (err == ESP_OK) err = nvs_commit(h);
+    nvs_close(h);
+  }
+  if (err != ESP_OK) ESP_LOGW(TAG, "Ranking not saved (%s)", esp_err_to_name(err));
+  return err;
+#else
+  return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+int ServerRanking::find(const char *server) const {
+  for (size_t i = 0; i < m_count; i++) {
+    if (strcmp(server, m_servers[i]) == 0) return (int)i;
+  }
+  return -1;
+}
+
+void ServerRanking::recordSuccess(const char *server, uint32_t latency_ms) {
+  if (latency_ms > UINT16_MAX) latency_ms = UINT16_MAX;
+  portENTER_CRITICAL(&m_lock);
+  int i = m_enabled ? find(server) : -1;
+  if (i >= 0) {
+    Entry &e = m_entries[i];
+    if (e.nameHash == 0) {
+      e = {nameHash(server), (uint16_t)latency_ms, 255, 0};
+    } else {
+      // success == 0: only failures so far, latency_ms is the placeholder
+      // recordFailure() put there, not a measurement to smooth
+      if (e.success == 0) e.latency_ms = (uint16_t)latency_ms;
+      else e.latency_ms = (uint16_t)(e.latency_ms + ((int32_t)latency_ms - e.latency_ms) / RANK_SMOOTHING);
+      e.success = (uint8_t)(e.success + (255 - e.success) / RANK_SMOOTHING);
+      e.failStreak = 0;
+    }
+  }
+  portEXIT_CRITICAL(&m_lock);
+}
+
+void ServerRanking::recordFailure(const char *server) {
+  portENTER_CRITICAL(&m_lock);
+  int i = m_enabled ? find(server) : -1;
+  if (i >= 0) {
+    Entry &e = m_entries[i];
+    if (e.nameHash == 0) {
+      e = {nameHash(server), SNTP_RANK_UNKNOWN_COST, 0, 1};   // latency not measured yet
+    } else {
+      e.success = (uint8_t)(e.success - e.success / RANK_SMOOTHING);
+      if (e.failStreak < UINT8_MAX) e.failStreak++;
+    }
+  }
+  portEXIT_CRITICAL(&m_lock);
+}
+
+// Expected time to a valid clock from this server, ms
+uint32_t ServerRanking::cost(const Entry &e) const {
+  if (e.nameHash == 0) return SNTP_RANK_UNKNOWN_COST;
+  return e.latency_ms + (uint32_t)(255 - e.success) * SNTP_RANK_FAIL_PENALTY / 255;
+}
+
+// Insertion sort on (failing, cost, list position): stable, and without
+// history the list order is kept as it is
+size_t ServerRanking::order(uint8_t *out) const {
+  uint64_t key[SNTP_RANK_MAX_SERVERS];
+  portENTER_CRITICAL(&m_lock);
+  size_t n = m_count;
+  for (size_t i = 0; i < n; i++) {
+    const Entry &e = m_entries[i];
+    bool failing = e.nameHash && e.failStreak >= SNTP_RANK_SKIP_AFTER;
+    key[i] = ((uint64_t)failing << 40) | ((uint64_t)cost(e) << 8) | i;
+  }
+  portEXIT_CRITICAL(&m_lock);
+
+  for (size_t i = 1; i < n; i++) {
+    uint64_t k = key[i];
+    size_t j = i;
+    for (; j > 0 && key[j - 1] > k; j--) key[j] = key[j - 1];
+    key[j] = k;
+  }
+  for (size_t i = 0; i < n; i++) out[i] = (uint8_t)(key[i] & 0xFF);
+  return n;
+}
+
+bool ServerRanking::hasHistory() const {
+  bool any = false;
+  portENTER_CRITICAL(&m_lock);
+  for (size_t i = 0; i < m_count; i++) any |= m_entries[i].nameHash != 0;
+  portEXIT_CRITICAL(&m_lock);
+  return any;
+}
+
+} // namespace ED_SNTP
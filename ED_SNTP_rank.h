@@ -0,0 +1,70 @@
+#pragma once
+
+// #region StdManifest
+/**
+ * @file ED_SNTP_rank.h
+ * @brief NTP server ranking learned from past syncs and kept in NVS.
+ *
+ * Each server of the list keeps a smoothed latency (time to a valid answer),
+ * a smoothed success rate and its current run of failures. order() puts the
+ * servers with the lowest expected cost first: latency plus a penalty for
+ * the failures. Servers failing SNTP_RANK_SKIP_AFTER times in a row go
+ * last, behind servers never tried, so they are only reached when everything
+ * else failed. Records are matched to servers by a hash of the name: a
+ * server added to or removed from the list does not shift the others.
+ *
+ * The ranking is stored as one small blob (CONFIG_ED_SNTP_SERVER_RANKING).
+ * Without NVS (not initialized by the application) it still works for the
+ * current boot.
+ */
+// #endregion
+
+#include "freertos/FreeRTOS.h"
+#include <esp_err.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ED_SNTP {
+
+#define SNTP_RANK_MAX_SERVERS    8
+#define SNTP_RANK_SKIP_AFTER     3      // consecutive failures that send a server to the back
+#define SNTP_RANK_FAIL_PENALTY   1000   // ms added to the cost of a server that always fails
+#define SNTP_RANK_UNKNOWN_COST   500    // ms, cost of a server with no history
+
+class ServerRanking {
+public:
+  ServerRanking();
+
+  // Binds the server list and reads the stored ranking. Records of servers
+  // no longer in the list are dropped at the next save().
+  void load(const char *const *servers, size_t count);
+  esp_err_t save();
+
+  // Unknown names (not in the list) are ignored
+  void recordSuccess(const char *server, uint32_t latency_ms);
+  void recordFailure(const char *server);
+
+  // Indexes into the list, best first; returns how many were written
+  size_t order(uint8_t *out) const;
+  bool hasHistory() const;
+
+private:
+  struct Entry {
+    uint32_t nameHash;     // 0 = no record
+    uint16_t latency_ms;
+    uint8_t success;       // 0..255
+    uint8_t failStreak;
+  };
+  struct Stored;
+
+  int find(const char *server) const;
+  uint32_t cost(const Entry &e) const;
+
+  Entry m_entries[SNTP_RANK_MAX_SERVERS];
+  const char *const *m_servers;
+  size_t m_count;
+  bool m_enabled;
+  mutable portMUX_TYPE m_lock;
+};
+
+} // namespace ED_SNTP
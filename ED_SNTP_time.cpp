@@ -13,21 +13,56 @@ namespace ED_SNTP {
 
 static const char *TAG = "ED_SNTP_time";
 
+#define SNTP_RESYNC_INTERVAL_S   3600      // default period of the drift-measuring resyncs
+#define DRIFT_MIN_INTERVAL_US    300000000 // syncs closer than this are too noisy for a rate
+#define DRIFT_MAX_PPB            200000    // crystal spec is tens of ppm: beyond is a clock step
+#define DRIFT_SMOOTHING          4         // each new measurement moves the estimate by 1/4
+#define NO_SECONDS               0xFF
+#define SNTP_RACE_TIMEOUT_MS     3000      // whole race, every server included
+#define SNTP_RACE_RETRY_MS       2000      // after a race nobody answered
+#define SNTP_NET_POLL_MS         500       // race mode: waiting for an IP
+#define SYNC_NOTIFY_DONE         (1u << 0) // syncTask: the SNTP client set the time
+#define SYNC_NOTIFY_SAVE_RANK    (1u << 1) // syncTask: a round failed, store the ranking
+
+// Position of the seconds digits in each ISOFORMAT output (4-digit years)
+static constexpr uint8_t SECONDS_POS[ISOFORMAT_COUNT] = {NO_SECONDS, 17, 17, 17, 17, NO_SECONDS, NO_SECONDS};
+
+static_assert(sizeof(NTPSERVER) / sizeof(NTPSERVER[0]) <= SNTP_RANK_MAX_SERVERS, "NTPSERVER exceeds the ranking");
+
+// Resync period as a task wait; 0 s = no resync. Multiplied in 64 bits and
+// kept below portMAX_DELAY, which would mean "never"
+static TickType_t resyncWait(uint32_t interval_s) {
+  if (interval_s == 0) return portMAX_DELAY;
+  uint64_t ticks = (uint64_t)interval_s * configTICK_RATE_HZ;
+  return ticks < portMAX_DELAY ? (TickType_t)ticks : portMAX_DELAY - 1;
+}
+
 // Mutex for all static variables
 portMUX_TYPE TimeSync::s_mutex = portMUX_INITIALIZER_UNLOCKED;
 
+SeqLock<TimeSync::ClockRef> TimeSync::s_reference;
+SeqLock<TimeSync::FormatCache> TimeSync::s_formatCache[ISOFORMAT_COUNT];
+std::atomic<uint32_t> TimeSync::s_tzGeneration{1};   // a zeroed cache entry never matches
+std::atomic<const TimeZoneInfo *> TimeSync::s_tzInfo{&timeZones[0]};
+SeqLock<TimeSync::TzYearCache> TimeSync::s_tzYear;
+
 bool TimeSync::s_initialized = false;
-bool TimeSync::s_RTCreferenceValid = false;
-time_t TimeSync::s_referenceUnixTime = 0;
-uint64_t TimeSync::s_referenceRTC_us = 0;
 std::string TimeSync::s_curSntpServer = "";
 bool TimeSync::s_networkAvailable = false;
 bool TimeSync::s_espSntp_initialized = false;
-bool TimeSync::s_initializeLaunched = false;
+std::atomic<bool> TimeSync::s_initializeLaunched{false};
 int64_t TimeSync::s_startRef = -1;
 int64_t TimeSync::s_timeout_ms = 1000;
 uint8_t TimeSync::s_curSNTPindex = 0;
+uint32_t TimeSync::s_resyncInterval_s = SNTP_RESYNC_INTERVAL_S;
+uint32_t TimeSync::s_driftSamples = 0;
 uint8_t TimeSync::s_numAvailableSNTP = sizeof(NTPSERVER) / sizeof(NTPSERVER[0]);
+SyncMode TimeSync::s_syncMode = SyncMode::SEQUENTIAL;
+ServerRanking TimeSync::s_ranking;
+uint8_t TimeSync::s_roundOrder[SNTP_RANK_MAX_SERVERS] = {};
+uint8_t TimeSync::s_roundLen = 0;
+int8_t TimeSync::s_roundPos = 0;
+int64_t TimeSync::s_launchRef = 0;
 TimeZone TimeSync::s_referenceTimeZone = TimeZone::CET;
 TimerHandle_t TimeSync::s_syncTimer = nullptr;
 TaskHandle_t TimeSync::s_syncTaskHandle = NULL;
@@ -58,25 +93,57 @@ void TimeSync::initialize(uint8_t serverIndex, TimeZone tz) {
 }
 
 void TimeSync::initialize(const char *ntpServer, TimeZone tz) {
+  const TimeZoneInfo *zone = findTimeZone(tz);
+  if (!zone) {
+    zone = &timeZones[0];
+    ESP_LOGE(TAG, "Timezone %d not enabled in menuconfig (ED_SNTP Time Zones), using %s", (int)tz,
+             zone->POSIX.data());
+    tz = zone->zone;
+  }
+
   portENTER_CRITICAL(&s_mutex);
   if (s_initialized) {
     // Already initialized – just update timezone if changed
-    if (s_referenceTimeZone != tz) {
-      s_referenceTimeZone = tz;
-      setenv("TZ", timeZones[static_cast<int>(tz)].POSIX.data(), 1);
-      tzset();
-      ESP_LOGI(TAG, "Timezone updated to %s", timeZones[(int)tz].POSIX.data());
-    }
+    bool changed = s_referenceTimeZone != tz;
+    s_referenceTimeZone = tz;
     portEXIT_CRITICAL(&s_mutex);
+    if (changed) {
+      applyTimeZone(zone);
+      ESP_LOGI(TAG, "Timezone updated to %s", zone->POSIX.data());
+    }
     return;
   }
   s_initialized = true;
   s_referenceTimeZone = tz;
   portEXIT_CRITICAL(&s_mutex);
 
-  setenv("TZ", timeZones[static_cast<int>(tz)].POSIX.data(), 1);
-  tzset();
-  ESP_LOGI(TAG, "TZ set to %s", timeZones[(int)tz].POSIX.data());
+  applyTimeZone(zone);
+  ESP_LOGI(TAG, "TZ set to %s", zone->POSIX.data());
+
+  // With a stored ranking the best server starts, unless the caller asked
+  // for one outside NTPSERVER, which the ranking cannot judge
+  s_ranking.load(NTPSERVER, s_numAvailableSNTP);
+  int8_t idx = getSNTPserverIndex(ntpServer);
+  bool ranked = s_ranking.hasHistory();
+  planRound(ranked ? -1 : idx);
+  if (idx < 0) {
+    portENTER_CRITICAL(&s_mutex);
+    s_roundPos = -1;
+    portEXIT_CRITICAL(&s_mutex);
+  } else if (ranked) {
+    ntpServer = NTPSERVER[s_roundOrder[0]];
+    ESP_LOGI(TAG, "Ranked start with %s", ntpServer);
+  }
+
+  if (s_syncMode != SyncMode::SEQUENTIAL) {
+    portENTER_CRITICAL(&s_mutex);
+    s_curSntpServer = ntpServer;
+    portEXIT_CRITICAL(&s_mutex);
+    if (s_syncTaskHandle == NULL) {
+      xTaskCreate(raceTask, "SNTP_RaceTask", 4096, NULL, 5, &s_syncTaskHandle);
+    }
+    return;
+  }
 
   // Create sync task only once
   if (s_syncTaskHandle == NULL) {
@@ -86,30 +153,80 @@ void TimeSync::initialize(const char *ntpServer, TimeZone tz) {
   launchWithServer(ntpServer);
 }
 
-// ----------------------------------------------------------------------
-// SNTP server management
-void TimeSync::launchWithServer(std::string server) {
+void TimeSync::setSyncMode(SyncMode mode) {
+  portENTER_CRITICAL(&s_mutex);
+  bool late = s_initialized;
+  if (!late) s_syncMode = mode;
+  portEXIT_CRITICAL(&s_mutex);
+  if (late) ESP_LOGW(TAG, "setSyncMode() after initialize(), ignored");
+}
+
+// Sequential order of one round: `first` (an NTPSERVER index, -1 = none),
+// then the ranking. Without history the ranking is the list order.
+void TimeSync::planRound(int8_t first) {
+  uint8_t order[SNTP_RANK_MAX_SERVERS];
+  size_t n = s_ranking.order(order);
   portENTER_CRITICAL(&s_mutex);
-  s_RTCreferenceValid = false;
-  s_espSntp_initialized = false; // will be set true after successful init
+  s_roundLen = 0;
+  if (first >= 0) s_roundOrder[s_roundLen++] = (uint8_t)first;
+  for (size_t i = 0; i < n; i++) {
+    if (order[i] != first) s_roundOrder[s_roundLen++] = order[i];
+  }
+  s_roundPos = 0;
   portEXIT_CRITICAL(&s_mutex);
+}
 
+// ----------------------------------------------------------------------
+// Timezone. TZ is still set for the application's own localtime() calls;
+// TimeSync converts through the compiled rule.
+const TimeZoneInfo *TimeSync::findTimeZone(TimeZone tz) {
+  for (const TimeZoneInfo &z : timeZones) {
+    if (z.zone == tz) return &z;
+  }
+  return nullptr;
+}
+
+void TimeSync::applyTimeZone(const TimeZoneInfo *zone) {
+  setenv("TZ", zone->POSIX.data(), 1);
+  tzset();
+  s_tzInfo.store(zone, std::memory_order_release);
+  s_tzGeneration++;
+}
+
+// A year's transitions are computed once and kept; any time in that year
+// is then converted with one or two compares.
+int32_t TimeSync::getUtcOffset(time_t utc) {
+  const TimeZoneInfo *zone = s_tzInfo.load(std::memory_order_acquire);
+  TzYearCache c;
+  s_tzYear.load(&c);
+  if (c.zone != zone || utc < c.year.yearStart || utc >= c.year.yearEnd) {
+    int64_t days = (int64_t)utc / 86400 - ((int64_t)utc % 86400 < 0);
+    c.zone = zone;
+    c.year = zone->rule.transitions(tzYearFromDays(days));
+    portENTER_CRITICAL(&s_mutex);
+    s_tzYear.store(c);
+    portEXIT_CRITICAL(&s_mutex);
+  }
+  return zone->rule.offsetAt(utc, c.year);
+}
+
+// ----------------------------------------------------------------------
+// SNTP server management
+// A valid reference stays in use while a resync or a server switch runs:
+// the RTC keeps counting on it until the new sync lands.
+void TimeSync::launchWithServer(std::string server) {
   if (!s_syncTimer)
     initInternalTimer();
 
-  // Check if network interface has IP
-  esp_netif_ip_info_t ip_info;
-  esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-  bool hasIP = (netif && esp_netif_get_ip_info(netif, &ip_info) == ESP_OK);
-
-  if (hasIP) {
+  if (hasNetwork()) {
     portENTER_CRITICAL(&s_mutex);
-    if (s_curSntpServer != server) {
+    if (s_curSntpServer != server || !s_espSntp_initialized) {
       if (s_espSntp_initialized) {
         esp_sntp_stop();
         s_espSntp_initialized = false;
       }
       s_curSntpServer = server;
+      s_launchRef = esp_timer_get_time();
       // Update index if server is in our list
       int idx = getSNTPserverIndex(server.c_str());
       s_curSNTPindex = (idx >= 0) ? (uint8_t)idx : 0;
@@ -140,6 +257,13 @@ void TimeSync::launchWithServer(std::string server) {
   }
 }
 
+// Check if network interface has IP
+bool TimeSync::hasNetwork() {
+  esp_netif_ip_info_t ip_info;
+  esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+  return netif && esp_netif_get_ip_info(netif, &ip_info) == ESP_OK;
+}
+
 // ----------------------------------------------------------------------
 // Timer callback (runs in timer task context)
 void TimeSync::onTimerStatic(TimerHandle_t xTimer) {
@@ -172,18 +296,23 @@ void TimeSync::onTimerStatic(TimerHandle_t xTimer) {
     return;
   }
 
-  // Timeout: switch to next server
+  // Timeout: switch to the next server of the round
   if ((now - start) > (timeout * 1000)) {
+    s_ranking.recordFailure(curServer.c_str());
     portENTER_CRITICAL(&s_mutex);
     s_startRef = -1;
-    // Find next server index
-    int8_t curIdx = getSNTPserverIndex(curServer.c_str());
-    if (curIdx < 0) curIdx = 0;
-    uint8_t nextIdx = (curIdx + 1) % s_numAvailableSNTP;
+    bool wrapped = ++s_roundPos >= s_roundLen;
     // Increase timeout for next attempt
     s_timeout_ms += 500;
-    std::string nextServer = NTPSERVER[nextIdx];
     portEXIT_CRITICAL(&s_mutex);
+    if (wrapped) {   // every server failed once: re-rank, syncTask stores what was learned
+      if (s_syncTaskHandle != NULL) xTaskNotify(s_syncTaskHandle, SYNC_NOTIFY_SAVE_RANK, eSetBits);
+      planRound(-1);
+    }
+    portENTER_CRITICAL(&s_mutex);
+    uint8_t nextIdx = s_roundOrder[s_roundPos];
+    portEXIT_CRITICAL(&s_mutex);
+    std::string nextServer = NTPSERVER[nextIdx];
 
     ESP_LOGW(TAG, "Timeout connecting to %s, switching to %s (timeout=%lld ms)",
              curServer.c_str(), nextServer.c_str(), s_timeout_ms);
@@ -199,23 +328,63 @@ void TimeSync::initInternalTimer() {
 }
 
 // ----------------------------------------------------------------------
-// Reference time capture (called from syncTask)
+// Reference publication. Callers hold s_mutex: writers are serialized and
+// no reader can preempt a half-written reference on the writer's core.
+void TimeSync::publishReference(const ClockRef &ref) {
+  s_reference.store(ref);
+}
+
+// ----------------------------------------------------------------------
+// Clock model: Unix time = reference + RTC elapsed * (1 + rate).
+// Split in whole seconds so the product stays in 64 bits for years.
+int64_t TimeSync::toEpoch_us(const ClockRef &ref, uint64_t rtc_us) {
+  int64_t d = (int64_t)(rtc_us - ref.rtc_us);
+  int64_t corr = (d / 1000000) * ref.rate_ppb / 1000 + (d % 1000000) * ref.rate_ppb / 1000000000;
+  return ref.unixTime_us + d + corr;
+}
+
+// ----------------------------------------------------------------------
+// Reference time capture (called from syncTask). Two syncs far enough
+// apart give the RTC rate error: NTP time elapsed against RTC time elapsed.
+// The sync task is the only writer, so `prev` needs no lock.
 void TimeSync::setReferenceTime() {
-  time_t now = 0;
-  time(&now);
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
   int64_t rtc_now = esp_timer_get_time();
+  setReferenceTime((int64_t)tv.tv_sec * 1000000 + tv.tv_usec, rtc_now);
+}
+
+void TimeSync::setReferenceTime(int64_t now_us, int64_t rtc_now) {
+  ClockRef prev = s_reference.load();
+  ClockRef ref = {now_us, (uint64_t)rtc_now, prev.rate_ppb, true};
+  int64_t rtcElapsed = rtc_now - (int64_t)prev.rtc_us;
+  if (prev.valid && rtcElapsed >= DRIFT_MIN_INTERVAL_US) {
+    // A step is recognised before any multiplication: the error of a real
+    // drift is at most DRIFT_MAX_PPB of the interval, so the rate below is
+    // bounded too and is computed in ms of RTC time to stay in 64 bits
+    int64_t error_us = (now_us - prev.unixTime_us) - rtcElapsed;
+    int64_t maxError_us = rtcElapsed / (1000000000 / DRIFT_MAX_PPB);
+    if (error_us > maxError_us || error_us < -maxError_us) {
+      ESP_LOGW(TAG, "Clock stepped by %lld us, drift estimate kept", (long long)error_us);
+    } else {
+      int64_t measured = error_us * 1000000 / (rtcElapsed / 1000);
+      ref.rate_ppb = s_driftSamples == 0 ? (int32_t)measured
+                                         : prev.rate_ppb + (int32_t)((measured - prev.rate_ppb) / DRIFT_SMOOTHING);
+      s_driftSamples++;
+      ESP_LOGI(TAG, "RTC drift %lld ppb over %lld s, estimate %ld ppb", (long long)measured,
+               (long long)(rtcElapsed / 1000000), (long)ref.rate_ppb);
+    }
+  }
 
   portENTER_CRITICAL(&s_mutex);
-  s_referenceUnixTime = now;
-  s_referenceRTC_us = rtc_now;
-  s_RTCreferenceValid = true;
+  publishReference(ref);
   portEXIT_CRITICAL(&s_mutex);
 
   tzset();
 
   std::string clocktime = getClockTime();
-  ESP_LOGI(TAG, "Reference captured: Unix=%lld, RTC=%lld, local time=%s",
-           (long long)now, (long long)rtc_now, clocktime.c_str());
+  ESP_LOGI(TAG, "Reference captured: Unix=%lld.%06ld, RTC=%lld, local time=%s",
+           (long long)(now_us / 1000000), (long)(now_us % 1000000), (long long)rtc_now, clocktime.c_str());
 }
 
 // ----------------------------------------------------------------------
@@ -223,16 +392,33 @@ void TimeSync::setReferenceTime() {
 void TimeSync::sync_cb(struct timeval *tv) {
   ESP_LOGI("SNTP", "Time synchronized: %ld", tv->tv_sec);
   if (s_syncTaskHandle != NULL) {
-    xTaskNotifyGive(s_syncTaskHandle);
+    xTaskNotify(s_syncTaskHandle, SYNC_NOTIFY_DONE, eSetBits);
   }
 }
 
 // ----------------------------------------------------------------------
 // Sync task – does the heavy lifting after sync completes
+// Once synced, it also runs the periodic resyncs that feed the drift estimate.
 void TimeSync::syncTask(void *arg) {
   while (true) {
-    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    portENTER_CRITICAL(&s_mutex);
+    uint32_t interval = s_resyncInterval_s;
+    portEXIT_CRITICAL(&s_mutex);
+    TickType_t wait = s_reference.load().valid ? resyncWait(interval) : portMAX_DELAY;
+    uint32_t bits = 0;
+    if (xTaskNotifyWait(0, UINT32_MAX, &bits, wait) == pdFALSE) {
+      ESP_LOGI(TAG, "Periodic resync with %s", s_curSntpServer.c_str());
+      planRound(getSNTPserverIndex(s_curSntpServer.c_str()));
+      launchWithServer(s_curSntpServer);
+      continue;
+    }
+    // Flash writes stay here: the timer task's stack is too small for NVS
+    if (bits & SYNC_NOTIFY_SAVE_RANK) s_ranking.save();
+    if (!(bits & SYNC_NOTIFY_DONE)) continue;
+    int64_t latency_ms = (esp_timer_get_time() - s_launchRef) / 1000;
     setReferenceTime();
+    s_ranking.recordSuccess(s_curSntpServer.c_str(), (uint32_t)latency_ms);
+    s_ranking.save();
 
     portENTER_CRITICAL(&s_mutex);
     if (s_espSntp_initialized) {
@@ -248,13 +434,78 @@ void TimeSync::syncTask(void *arg) {
   }
 }
 
+// ----------------------------------------------------------------------
+// Race mode task: replaces the SNTP client, the timer and syncTask. Every
+// server is queried at once (the configured one first), the winner sets the
+// system time and the reference, and the race is run again for each resync.
+void TimeSync::raceTask(void *arg) {
+  RacePolicy policy = s_syncMode == SyncMode::RACE_BEST_RTT ? RacePolicy::BEST_RTT : RacePolicy::FIRST_VALID;
+  while (true) {
+    while (!hasNetwork()) {
+      portENTER_CRITICAL(&s_mutex);
+      s_networkAvailable = false;
+      portEXIT_CRITICAL(&s_mutex);
+      vTaskDelay(pdMS_TO_TICKS(SNTP_NET_POLL_MS));
+    }
+    portENTER_CRITICAL(&s_mutex);
+    s_networkAvailable = true;
+    std::string first = s_curSntpServer;
+    portEXIT_CRITICAL(&s_mutex);
+
+    // Requests leave in ranking order; the configured server leads when
+    // there is no history yet or when it is not in NTPSERVER
+    const char *servers[NTP_RACE_MAX_SERVERS];
+    size_t count = 0;
+    uint8_t order[SNTP_RANK_MAX_SERVERS];
+    size_t n = s_ranking.order(order);
+    int8_t firstIdx = getSNTPserverIndex(first.c_str());
+    bool leadFirst = firstIdx < 0 || !s_ranking.hasHistory();
+    if (leadFirst) servers[count++] = first.c_str();
+    for (size_t i = 0; i < n && count < NTP_RACE_MAX_SERVERS; i++) {
+      if (leadFirst && order[i] == firstIdx) continue;
+      servers[count++] = NTPSERVER[order[i]];
+    }
+
+    int64_t start = esp_timer_get_time();
+    NtpReply r;
+    uint32_t rtt[NTP_RACE_MAX_SERVERS];
+    esp_err_t err = ntpRace(servers, count, policy, SNTP_RACE_TIMEOUT_MS, &r, rtt);
+    for (size_t i = 0; i < count; i++) {
+      if (rtt[i] == NTP_RACE_FAILED) s_ranking.recordFailure(servers[i]);
+      else if (rtt[i] != NTP_RACE_CANCELLED) s_ranking.recordSuccess(servers[i], (rtt[i] + 999) / 1000);
+    }
+    s_ranking.save();
+    TickType_t wait = pdMS_TO_TICKS(SNTP_RACE_RETRY_MS);
+    if (err == ESP_OK) {
+      // System time follows, as the SNTP client would have set it
+      int64_t now_us = r.unixTime_us + (esp_timer_get_time() - (int64_t)r.rtc_us);
+      struct timeval tv = {(time_t)(now_us / 1000000), (suseconds_t)(now_us % 1000000)};
+      settimeofday(&tv, nullptr);
+      setReferenceTime(r.unixTime_us, (int64_t)r.rtc_us);
+      portENTER_CRITICAL(&s_mutex);
+      s_curSntpServer = servers[r.server];
+      portEXIT_CRITICAL(&s_mutex);
+      ESP_LOGI(TAG, "Sync completed with %s in %lld ms (rtt %lu us, %u of %u servers answered)",
+               servers[r.server], (long long)((r.rtc_us - start) / 1000), (unsigned long)r.rtt_us,
+               r.replies, (unsigned)count);
+
+      portENTER_CRITICAL(&s_mutex);
+      uint32_t interval = s_resyncInterval_s;
+      s_initializeLaunched = false;
+      portEXIT_CRITICAL(&s_mutex);
+      wait = resyncWait(interval);
+    } else {
+      ESP_LOGW(TAG, "No server answered (%s), racing again in %d ms", esp_err_to_name(err), SNTP_RACE_RETRY_MS);
+    }
+    ulTaskNotifyTake(pdTRUE, wait);
+  }
+}
+
 // ----------------------------------------------------------------------
 // Public time getters
 std::string TimeSync::getClockTime(ISOFORMAT format) {
-  portENTER_CRITICAL(&s_mutex);
-  bool valid = s_RTCreferenceValid;
+  bool valid = s_reference.load().valid;
   bool launched = s_initializeLaunched;
-  portEXIT_CRITICAL(&s_mutex);
 
   if (!valid) {
     if (!launched) {
@@ -268,17 +519,16 @@ std::string TimeSync::getClockTime(ISOFORMAT format) {
     }
     return "- no valid clock on ESP -";
   }
-  time_t now = time(nullptr);
-  return getClockTime_str(now, format);
+  char buffer[64];
+  formatClockTime(getEpochTime_us(), format, buffer, sizeof(buffer));
+  return std::string(buffer);
 }
 
-void TimeSync::getClockTime(ISOFORMAT format, char* outBuf, size_t outSize) {
+void TimeSync::getClockTime(ISOFORMAT format, char* outBuf, size_t outSize, bool millis) {
   if (!outBuf || outSize == 0) return;
 
-  portENTER_CRITICAL(&s_mutex);
-  bool valid = s_RTCreferenceValid;
+  bool valid = s_reference.load().valid;
   bool launched = s_initializeLaunched;
-  portEXIT_CRITICAL(&s_mutex);
 
   if (!valid) {
     if (!launched) {
@@ -293,16 +543,14 @@ void TimeSync::getClockTime(ISOFORMAT format, char* outBuf, size_t outSize) {
     snprintf(outBuf, outSize, "- no valid clock on ESP -");
     return;
   }
-  time_t now = time(nullptr);
-  getClockTime_str(now, format, outBuf, outSize);
+  formatClockTime(getEpochTime_us(), format, outBuf, outSize, millis);
 }
 
 std::string TimeSync::getClockTime(uint64_t rtTicks, TICKTYPE ttype, ISOFORMAT format) {
-  portENTER_CRITICAL(&s_mutex);
-  bool valid = s_RTCreferenceValid;
-  uint64_t refRTC = s_referenceRTC_us;
-  time_t refUnix = s_referenceUnixTime;
-  portEXIT_CRITICAL(&s_mutex);
+  ClockRef ref = s_reference.load();
+  bool valid = ref.valid;
+  uint64_t refRTC = ref.rtc_us;
+  int64_t refUnix = ref.unixTime_us;
 
   if (!valid || refUnix == 0 || refRTC == 0) {
     if (!s_initializeLaunched) {
@@ -317,22 +565,17 @@ std::string TimeSync::getClockTime(uint64_t rtTicks, TICKTYPE ttype, ISOFORMAT f
     return "- no valid clock on ESP -";
   }
 
-  uint64_t deltaMicros;
-  if (ttype == TICKTYPE::TICK_US) {
-    deltaMicros = rtTicks - refRTC;
-  } else {
-    deltaMicros = (rtTicks * 1000ULL) - refRTC;
-  }
-  time_t epoch = refUnix + (deltaMicros / 1000000ULL);
-  return getClockTime_str(epoch, format);
+  uint64_t rtc_us = (ttype == TICKTYPE::TICK_US) ? rtTicks : rtTicks * 1000ULL;
+  char buffer[64];
+  formatClockTime((uint64_t)toEpoch_us(ref, rtc_us), format, buffer, sizeof(buffer));
+  return std::string(buffer);
 }
 
 uint64_t TimeSync::getEpochTime(uint64_t rtTicks) {
-  portENTER_CRITICAL(&s_mutex);
-  bool valid = s_RTCreferenceValid;
-  uint64_t refRTC = s_referenceRTC_us;
-  time_t refUnix = s_referenceUnixTime;
-  portEXIT_CRITICAL(&s_mutex);
+  ClockRef ref = s_reference.load();
+  bool valid = ref.valid;
+  uint64_t refRTC = ref.rtc_us;
+  int64_t refUnix = ref.unixTime_us;
 
   if (!valid || refUnix == 0 || refRTC == 0) {
     if (!s_initializeLaunched) {
@@ -346,14 +589,153 @@ uint64_t TimeSync::getEpochTime(uint64_t rtTicks) {
     }
     return 0;
   }
-  uint64_t deltaMicros = rtTicks - refRTC;
-  return refUnix + (deltaMicros / 1000000ULL);
+  return (uint64_t)(toEpoch_us(ref, rtTicks) / 1000000);
 }
 
 uint64_t TimeSync::getEpochTime() {
   return getEpochTime(esp_timer_get_time());
 }
 
+uint64_t TimeSync::getEpochTime_us(uint64_t rtc_us) {
+  ClockRef ref = s_reference.load();
+  if (!ref.valid) return 0;
+  return (uint64_t)toEpoch_us(ref, rtc_us);
+}
+
+uint64_t TimeSync::getEpochTime_us() {
+  return getEpochTime_us(esp_timer_get_time());
+}
+
+uint64_t TimeSync::getEpochTime_ms(uint64_t rtc_us) {
+  return getEpochTime_us(rtc_us) / 1000;
+}
+
+uint64_t TimeSync::getEpochTime_ms() {
+  return getEpochTime_us(esp_timer_get_time()) / 1000;
+}
+
+int32_t TimeSync::getClockDrift_ppb() {
+  return s_reference.load().rate_ppb;
+}
+
+void TimeSync::setResyncInterval(uint32_t seconds) {
+  portENTER_CRITICAL(&s_mutex);
+  s_resyncInterval_s = seconds;
+  portEXIT_CRITICAL(&s_mutex);
+}
+
+// ----------------------------------------------------------------------
+// Memoized formatter. Every output only changes its seconds digits within
+// a minute (DST transitions and local midnight fall on whole minutes), so
+// the text of the current minute is kept per format and only the seconds,
+// and the optional milliseconds, are written per call. A miss builds the
+// minute once through getClockTime_str(), which keeps the output identical
+// to the strftime() path. The cache is read through a seqlock.
+size_t TimeSync::formatClockTime(uint64_t epoch_us, ISOFORMAT format, char *outBuf, size_t outSize, bool millis) {
+  if (!outBuf || outSize == 0) return 0;
+  int f = static_cast<int>(format);
+  if (f < 0 || f >= ISOFORMAT_COUNT) {
+    outBuf[0] = '\0';
+    return 0;
+  }
+  FormatCache c;
+  loadFormatCache(f, (int64_t)(epoch_us / 60000000), &c);
+  return renderCached(c, epoch_us, millis, outBuf, outSize);
+}
+
+// Text of `minute` for format `f`, from the shared cache or built and stored
+void TimeSync::loadFormatCache(int f, int64_t minute, FormatCache *c) {
+  uint32_t tzGen = s_tzGeneration.load(std::memory_order_relaxed);
+  s_formatCache[f].load(c);
+  if (c->minute == minute && c->tzGen == tzGen) return;
+
+  char text[sizeof(c->text)];
+  getClockTime_str((time_t)(minute * 60), static_cast<ISOFORMAT>(f), text, sizeof(text));
+  c->minute = minute;
+  c->tzGen = tzGen;
+  c->len = (uint8_t)strlen(text);
+  c->secPos = (SECONDS_POS[f] != NO_SECONDS && c->len >= SECONDS_POS[f] + 2) ? SECONDS_POS[f] : NO_SECONDS;
+  memcpy(c->text, text, sizeof(c->text));
+  portENTER_CRITICAL(&s_mutex);
+  s_formatCache[f].store(*c);
+  portEXIT_CRITICAL(&s_mutex);
+}
+
+// Minute text with the seconds (and milliseconds) of `epoch_us` written in
+size_t TimeSync::renderCached(const FormatCache &c, uint64_t epoch_us, bool millis, char *outBuf, size_t outSize) {
+  bool ms = millis && c.secPos != NO_SECONDS;
+  size_t len = c.len + (ms ? 4 : 0);
+  if (len >= outSize) {   // strftime() writes nothing useful either
+    outBuf[0] = '\0';
+    return 0;
+  }
+  if (c.secPos == NO_SECONDS) {
+    memcpy(outBuf, c.text, c.len + 1);
+    return len;
+  }
+
+  size_t tail = c.secPos + 2;   // just after the seconds digits
+  memcpy(outBuf, c.text, tail);
+  uint32_t ss = (uint32_t)(epoch_us / 1000000 % 60);
+  outBuf[c.secPos] = (char)('0' + ss / 10);
+  outBuf[c.secPos + 1] = (char)('0' + ss % 10);
+  char *p = outBuf + tail;
+  if (ms) {
+    uint32_t mmm = (uint32_t)(epoch_us / 1000 % 1000);
+    p[0] = '.';
+    p[1] = (char)('0' + mmm / 100);
+    p[2] = (char)('0' + mmm / 10 % 10);
+    p[3] = (char)('0' + mmm % 10);
+    p += 4;
+  }
+  memcpy(p, c.text + tail, c.len - tail + 1);
+  return len;
+}
+
+// ----------------------------------------------------------------------
+// Batch conversion. One reference snapshot for the whole array: a resync
+// landing meanwhile cannot split it between two references. The loops
+// carry no lock, log or branch on the reference; the formatter keeps the
+// minute text in a local copy and goes to the shared cache only when the
+// minute changes.
+size_t TimeSync::getEpochTimes(const uint64_t *rtTicks, uint64_t *epochOut, size_t count, TICKTYPE ttype) {
+  if (!rtTicks || !epochOut) return 0;
+  ClockRef ref = s_reference.load();
+  if (!ref.valid) return 0;
+
+  if (ttype == TICKTYPE::TICK_US) {
+    for (size_t i = 0; i < count; i++) epochOut[i] = (uint64_t)toEpoch_us(ref, rtTicks[i]);
+  } else {
+    for (size_t i = 0; i < count; i++) epochOut[i] = (uint64_t)toEpoch_us(ref, rtTicks[i] * 1000ULL) / 1000;
+  }
+  return count;
+}
+
+size_t TimeSync::formatClockTimes(const uint64_t *rtTicks, size_t count, TICKTYPE ttype, ISOFORMAT format,
+                                  char *outBuf, size_t outSize, bool millis) {
+  if (!rtTicks || !outBuf || outSize == 0) return 0;
+  outBuf[0] = '\0';
+  int f = static_cast<int>(format);
+  if (f < 0 || f >= ISOFORMAT_COUNT) return 0;
+  ClockRef ref = s_reference.load();
+  if (!ref.valid) return 0;
+
+  uint64_t scale = ttype == TICKTYPE::TICK_US ? 1 : 1000;
+  FormatCache c;
+  c.minute = -1;
+  size_t used = 0;
+  size_t i = 0;
+  for (; i < count && used < outSize; i++) {
+    uint64_t epoch_us = (uint64_t)toEpoch_us(ref, rtTicks[i] * scale);
+    int64_t minute = (int64_t)(epoch_us / 60000000);
+    if (minute != c.minute) loadFormatCache(f, minute, &c);
+    size_t len = renderCached(c, epoch_us, millis, outBuf + used, outSize - used);
+    if (len == 0) break;
+    used += len + 1;
+  }
+  return i;
+}
+
 // ----------------------------------------------------------------------
 // String formatting helpers (fixed epoch overwrite bug)
 std::string TimeSync::getClockTime_str(time_t epoch, ISOFORMAT format) {
@@ -365,27 +747,36 @@ std::string TimeSync::getClockTime_str(time_t epoch, ISOFORMAT format) {
 void TimeSync::getClockTime_str(time_t epoch, ISOFORMAT format, char* outBuf, size_t outSize) {
   if (!outBuf || outSize == 0) return;
 
-  // Use provided epoch, do NOT overwrite with time(NULL)
+  // Use provided epoch, do NOT overwrite with time(NULL). Local time is UTC
+  // shifted by the compiled rule's offset, so only gmtime_r() is needed and
+  // %z, which strftime() would take from TZ, is written from the offset.
+  int32_t offset = getUtcOffset(epoch);
+  bool utc = format == ISOFORMAT::DATETIME_UTC || format == ISOFORMAT::DATETIME_UTC_OFFSET;
+  time_t shown = utc ? epoch : epoch + offset;
   struct tm timeinfo;
-  if (format == ISOFORMAT::DATETIME_UTC || format == ISOFORMAT::DATETIME_UTC_OFFSET) {
-    gmtime_r(&epoch, &timeinfo);
-  } else {
-    localtime_r(&epoch, &timeinfo);
+  gmtime_r(&shown, &timeinfo);
+
+  const char *fmt = ISOFORMAT_STRINGS[static_cast<int>(format)];
+  bool withOffset = format == ISOFORMAT::DATETIME_OFFSET || format == ISOFORMAT::DATETIME_UTC_OFFSET;
+  char base[24];
+  if (withOffset) {   // same format without its trailing %z
+    size_t n = strlen(fmt) - 2;
+    memcpy(base, fmt, n);
+    base[n] = '\0';
+    fmt = base;
+  }
+  size_t len = strftime(outBuf, outSize, fmt, &timeinfo);
+  if (len == 0) {
+    outBuf[0] = '\0';
+    return;
   }
 
-  strftime(outBuf, outSize, ISOFORMAT_STRINGS[static_cast<int>(format)], &timeinfo);
-
-  if (format == ISOFORMAT::DATETIME_UTC_OFFSET) {
-    // Correct offset handling: replace wrong %z with local offset
-    struct tm localInfo;
-    char tzOffsStr[7] = "";
-    localtime_r(&epoch, &localInfo);
-    strftime(tzOffsStr, sizeof(tzOffsStr), "%z", &localInfo);
-    size_t len = strlen(outBuf);
-    if (len > 5) {
-      outBuf[len - 5] = '\0';   // trim the incorrect Z+0000 part
-    }
-    strncat(outBuf, tzOffsStr, outSize - strlen(outBuf) - 1);
+  if (withOffset) {
+    uint32_t a = offset < 0 ? -offset : offset;
+    char tzOffsStr[6] = {offset < 0 ? '-' : '+',
+                         (char)('0' + a / 36000), (char)('0' + a / 3600 % 10),
+                         (char)('0' + a / 600 % 6), (char)('0' + a / 60 % 10), '\0'};
+    strncat(outBuf, tzOffsStr, outSize - len - 1);
   }
 }
 
@@ -18,8 +18,11 @@
 #include <string>
 #include <time.h>
 #include <atomic>
-
-#define TZ_EXCLUDE_AMERICA
+#include "ED_seqlock.h"
+#include "ED_SNTP_tz.h"
+#include "ED_SNTP_race.h"
+#include "ED_SNTP_rank.h"
+#include "sdkconfig.h"
 
 namespace ED_SNTP {
 
@@ -45,44 +48,88 @@ struct TimeZoneInfo {
   TimeZone zone;
   std::string_view readableId;
   std::string_view POSIX;
+  TzRule rule;   // POSIX compiled at build time
 };
 
-#ifdef TZ_EXCLUDE_AMERICA
-#define TIMEZONE_COUNT 4
-#else
-#define TIMEZONE_COUNT 15
-#endif
+constexpr TimeZoneInfo tzEntry(TimeZone zone, std::string_view readableId, std::string_view posix) {
+  return {zone, readableId, posix, tzCompile(posix)};
+}
 
-static constexpr TimeZoneInfo timeZones[TIMEZONE_COUNT] = {
-    {TimeZone::CET, "Central European Time", "CET-1CEST,M3.5.0/2,M10.5.0/3"},
-    {TimeZone::WET, "Western European Time", "WET0WEST,M3.5.0/1,M10.5.0/2"},
-    {TimeZone::EET, "Eastern European Time", "EET-2EEST,M3.5.0/3,M10.5.0/4"},
-    {TimeZone::UK_GMT, "United Kingdom Time", "GMT0BST,M3.5.0/1,M10.5.0/2"}
-#ifndef TZ_EXCLUDE_AMERICA
-    ,
-    {TimeZone::EST, "Eastern Time (US & Canada)", "EST5EDT,M3.2.0/2,M11.1.0/2"},
-    {TimeZone::CST, "Central Time (US & Canada)", "CST6CDT,M3.2.0/2,M11.1.0/2"},
-    {TimeZone::MST, "Mountain Time (US & Canada)", "MST7MDT,M3.2.0/2,M11.1.0/2"},
-    {TimeZone::PST, "Pacific Time (US & Canada)", "PST8PDT,M3.2.0/2,M11.1.0/2"},
-    {TimeZone::AKST, "Alaska Time", "AKST9AKDT,M3.2.0/2,M11.1.0/2"},
-    {TimeZone::HST, "Hawaii Standard Time", "HST10"},
-    {TimeZone::ARIZONA, "Arizona (No DST)", "MST7"},
-    {TimeZone::SASKATCHEWAN, "Saskatchewan (No DST)", "CST6"},
-    {TimeZone::MEXICO_CITY, "Mexico City", "CST6CDT,M4.1.0/2,M10.5.0/2"},
-    {TimeZone::BAJA_CALIFORNIA, "Baja California", "PST8PDT,M4.1.0/2,M10.5.0/2"},
-    {TimeZone::SONORA, "Sonora (No DST)", "MST7"}
+// Zones are selected in menuconfig (ED_SNTP Time Zones); CET, the default,
+// is always present. Zones left out cost no flash.
+static constexpr TimeZoneInfo timeZones[] = {
+    tzEntry(TimeZone::CET, "Central European Time", "CET-1CEST,M3.5.0/2,M10.5.0/3"),
+#if CONFIG_ED_SNTP_TZ_WET
+    tzEntry(TimeZone::WET, "Western European Time", "WET0WEST,M3.5.0/1,M10.5.0/2"),
+#endif
+#if CONFIG_ED_SNTP_TZ_EET
+    tzEntry(TimeZone::EET, "Eastern European Time", "EET-2EEST,M3.5.0/3,M10.5.0/4"),
+#endif
+#if CONFIG_ED_SNTP_TZ_UK_GMT
+    tzEntry(TimeZone::UK_GMT, "United Kingdom Time", "GMT0BST,M3.5.0/1,M10.5.0/2"),
+#endif
+#if CONFIG_ED_SNTP_TZ_EST
+    tzEntry(TimeZone::EST, "Eastern Time (US & Canada)", "EST5EDT,M3.2.0/2,M11.1.0/2"),
+#endif
+#if CONFIG_ED_SNTP_TZ_CST
+    tzEntry(TimeZone::CST, "Central Time (US & Canada)", "CST6CDT,M3.2.0/2,M11.1.0/2"),
+#endif
+#if CONFIG_ED_SNTP_TZ_MST
+    tzEntry(TimeZone::MST, "Mountain Time (US & Canada)", "MST7MDT,M3.2.0/2,M11.1.0/2"),
+#endif
+#if CONFIG_ED_SNTP_TZ_PST
+    tzEntry(TimeZone::PST, "Pacific Time (US & Canada)", "PST8PDT,M3.2.0/2,M11.1.0/2"),
+#endif
+#if CONFIG_ED_SNTP_TZ_AKST
+    tzEntry(TimeZone::AKST, "Alaska Time", "AKST9AKDT,M3.2.0/2,M11.1.0/2"),
+#endif
+#if CONFIG_ED_SNTP_TZ_HST
+    tzEntry(TimeZone::HST, "Hawaii Standard Time", "HST10"),
+#endif
+#if CONFIG_ED_SNTP_TZ_ARIZONA
+    tzEntry(TimeZone::ARIZONA, "Arizona (No DST)", "MST7"),
+#endif
+#if CONFIG_ED_SNTP_TZ_SASKATCHEWAN
+    tzEntry(TimeZone::SASKATCHEWAN, "Saskatchewan (No DST)", "CST6"),
+#endif
+#if CONFIG_ED_SNTP_TZ_MEXICO_CITY
+    tzEntry(TimeZone::MEXICO_CITY, "Mexico City", "CST6CDT,M4.1.0/2,M10.5.0/2"),
+#endif
+#if CONFIG_ED_SNTP_TZ_BAJA_CALIFORNIA
+    tzEntry(TimeZone::BAJA_CALIFORNIA, "Baja California", "PST8PDT,M4.1.0/2,M10.5.0/2"),
+#endif
+#if CONFIG_ED_SNTP_TZ_SONORA
+    tzEntry(TimeZone::SONORA, "Sonora (No DST)", "MST7"),
 #endif
 };
 
+#define TIMEZONE_COUNT (sizeof(timeZones) / sizeof(timeZones[0]))
+
+constexpr bool tzTableValid() {
+  for (const TimeZoneInfo &z : timeZones) {
+    if (!z.rule.valid) return false;
+  }
+  return true;
+}
+static_assert(tzTableValid(), "unsupported POSIX TZ string in timeZones[]");
+
 static constexpr const char *NTPSERVER[] = {
     "ntp.inrim.it", "time.cloudflare.com", "europe.pool.ntp.org",
     "pool.ntp.org", "raspi00"};
 
+enum class SyncMode {
+  SEQUENTIAL,         // ESP-IDF SNTP client, one server at a time, next one on timeout
+  RACE_FIRST_VALID,   // query every server at once, first valid reply wins
+  RACE_BEST_RTT       // query every server at once, shortest round trip wins
+};
+
 enum class TICKTYPE {
   TICK_MS,
   TICK_US
 };
 
+#define ISOFORMAT_COUNT 7
+
 enum class ISOFORMAT {
   DATE_ONLY,
   DATETIME_LOCAL,
@@ -108,13 +155,49 @@ public:
   static void initialize(const char *ntpServer = NTPSERVER[0], TimeZone tz = TimeZone::CET);
   static void initialize(uint8_t serverIndex, TimeZone tz = TimeZone::CET);
 
+  // Call before initialize(). The race modes query `ntpServer` and the
+  // other NTPSERVER entries together, see ED_SNTP_race.h.
+  static void setSyncMode(SyncMode mode);
+
   static std::string getClockTime(ISOFORMAT format = ISOFORMAT::DATETIME_UTC_OFFSET);
   static std::string getClockTime(uint64_t rtTicks, TICKTYPE ttype = TICKTYPE::TICK_MS, ISOFORMAT format = ISOFORMAT::DATETIME_OFFSET);
-  static void getClockTime(ISOFORMAT format, char *outBuf, size_t outSize);
+  // `millis` adds ".mmm" after the seconds of the formats that have them
+  static void getClockTime(ISOFORMAT format, char *outBuf, size_t outSize, bool millis = false);
+  // Allocation-free formatting of an epoch in µs, memoized per minute: no libc
+  // time call unless the minute, the format or the timezone changed.
+  // Returns the length written, 0 (and an empty string) if it does not fit.
+  static size_t formatClockTime(uint64_t epoch_us, ISOFORMAT format, char *outBuf, size_t outSize,
+                                bool millis = false);
 
   static uint64_t getEpochTime(uint64_t rtTicks);
   static uint64_t getEpochTime();
 
+  // Epoch in µs / ms from an esp_timer value (or now), corrected for the RTC
+  // drift measured between syncs. 0 until the first sync.
+  static uint64_t getEpochTime_us(uint64_t rtc_us);
+  static uint64_t getEpochTime_us();
+  static uint64_t getEpochTime_ms(uint64_t rtc_us);
+  static uint64_t getEpochTime_ms();
+  // Batch conversion of stored esp_timer values, `ttype` units in and out
+  // (µs -> epoch µs, ms -> epoch ms). The reference is read once for the
+  // whole array, nothing is logged or allocated. Returns `count`, or 0
+  // (nothing written) until the first sync.
+  static size_t getEpochTimes(const uint64_t *rtTicks, uint64_t *epochOut, size_t count,
+                              TICKTYPE ttype = TICKTYPE::TICK_US);
+  // Same, formatted: NUL-terminated strings packed back to back in outBuf.
+  // Stops at the first one that does not fit; returns how many were written.
+  static size_t formatClockTimes(const uint64_t *rtTicks, size_t count, TICKTYPE ttype, ISOFORMAT format,
+                                 char *outBuf, size_t outSize, bool millis = false);
+  // Current RTC rate correction, parts per billion (positive = RTC slow)
+  static int32_t getClockDrift_ppb();
+  // Period of the resyncs that measure the drift, 0 = sync once. Applies
+  // from the next wait of the sync task.
+  static void setResyncInterval(uint32_t seconds);
+
+  // Offset of the selected timezone from UTC at `utc`, seconds east.
+  // From the compiled rule: no TZ parsing, no libc call.
+  static int32_t getUtcOffset(time_t utc);
+
 private:
   static std::string getClockTime_str(time_t epoch, ISOFORMAT format);
   static void getClockTime_str(time_t epoch, ISOFORMAT format, char *outBuf, size_t outSize);
@@ -124,23 +207,70 @@ private:
   static int8_t getSNTPserverIndex(const char *ntpServer);
   static uint8_t validateSNTPindex(uint8_t proposedIndex);
   static void setReferenceTime();
+  static void setReferenceTime(int64_t now_us, int64_t rtc_now);
+  static bool hasNetwork();
   static void syncTask(void *arg);
+  static void raceTask(void *arg);
+  static void planRound(int8_t first);
   static void sync_cb(struct timeval *tv);
+  static const TimeZoneInfo *findTimeZone(TimeZone tz);
+  static void applyTimeZone(const TimeZoneInfo *zone);
+
+  // RTC <-> Unix time reference. Written under s_mutex, read through the
+  // seqlock: the getters never block and never mask interrupts.
+  struct ClockRef {
+    int64_t unixTime_us;   // Unix time at the sync, µs
+    uint64_t rtc_us;       // esp_timer at the same instant
+    int32_t rate_ppb;      // RTC rate error, see getClockDrift_ppb()
+    bool valid;
+  };
+  // Text of one ISOFORMAT for one minute, see formatClockTime()
+  struct FormatCache {
+    int64_t minute;        // epoch / 60
+    uint32_t tzGen;        // s_tzGeneration it was built with
+    uint8_t len;
+    uint8_t secPos;        // first seconds digit
+    char text[32];
+  };
+  static SeqLock<FormatCache> s_formatCache[ISOFORMAT_COUNT];
+  static void loadFormatCache(int f, int64_t minute, FormatCache *c);
+  static size_t renderCached(const FormatCache &c, uint64_t epoch_us, bool millis, char *outBuf, size_t outSize);
+  static std::atomic<uint32_t> s_tzGeneration;
+
+  // Transitions of the year last converted, recomputed when a time falls
+  // outside it or the zone changes
+  struct TzYearCache {
+    const TimeZoneInfo *zone;
+    TzYear year;
+  };
+  static std::atomic<const TimeZoneInfo *> s_tzInfo;
+  static SeqLock<TzYearCache> s_tzYear;
+
+  static void publishReference(const ClockRef &ref);
+  static int64_t toEpoch_us(const ClockRef &ref, uint64_t rtc_us);
+  static SeqLock<ClockRef> s_reference;
 
   // Shared state protected by s_mutex
   static portMUX_TYPE s_mutex;
   static bool s_initialized;           // prevent duplicate init
-  static bool s_RTCreferenceValid;
-  static time_t s_referenceUnixTime;
-  static uint64_t s_referenceRTC_us;
   static std::string s_curSntpServer;
   static bool s_networkAvailable;
   static bool s_espSntp_initialized;
-  static bool s_initializeLaunched;    // auto‑recovery flag
+  static std::atomic<bool> s_initializeLaunched;    // auto‑recovery flag, read lock-free
   static int64_t s_startRef;
   static int64_t s_timeout_ms;
   static uint8_t s_curSNTPindex;
+  static uint32_t s_resyncInterval_s;
+  static uint32_t s_driftSamples;
   static uint8_t s_numAvailableSNTP;
+  static SyncMode s_syncMode;
+  // Server ranking (ED_SNTP_rank.h) and the sequential order of the current
+  // round: each server once, best first; re-ranked when the round wraps
+  static ServerRanking s_ranking;
+  static uint8_t s_roundOrder[SNTP_RANK_MAX_SERVERS];
+  static uint8_t s_roundLen;
+  static int8_t s_roundPos;            // -1: a server outside NTPSERVER goes first
+  static int64_t s_launchRef;          // esp_timer when the SNTP client was started
   static TimeZone s_referenceTimeZone;
   static TimerHandle_t s_syncTimer;
   static TaskHandle_t s_syncTaskHandle;
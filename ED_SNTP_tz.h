@@ -0,0 +1,176 @@
+#pragma once
+
+// #region StdManifest
+/**
+ * @file ED_SNTP_tz.h
+ * @brief POSIX TZ rules compiled at build time into UTC offset transitions.
+ *
+ * A rule string of the timezone table ("CET-1CEST,M3.5.0/2,M10.5.0/3") is
+ * parsed by the compiler into a TzRule: standard and DST offsets and the two
+ * "Mm.w.d/time" transition dates. TzRule::transitions() turns it into the
+ * UTC instants of the two transitions of a year with integer arithmetic
+ * only, so converting UTC to local time is a compare and an add. A string
+ * the parser does not support fails the build.
+ */
+// #endregion
+
+#include <stdint.h>
+#include <string_view>
+
+namespace ED_SNTP {
+
+/// "Mm.w.d/time": day `wday` (0 = Sunday) of week `week` (5 = last) of `month`, at local `time_s`
+struct TzDate {
+  uint8_t month;
+  uint8_t week;
+  uint8_t wday;
+  int32_t time_s;
+};
+
+/// UTC bounds of one year and of its DST period
+struct TzYear {
+  int64_t yearStart;
+  int64_t yearEnd;
+  int64_t dstStart;
+  int64_t dstEnd;
+};
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's algorithm)
+constexpr int64_t tzDaysFromCivil(int32_t y, uint32_t m, uint32_t d) {
+  y -= m <= 2;
+  const int32_t era = (y >= 0 ? y : y - 399) / 400;
+  const uint32_t yoe = (uint32_t)(y - era * 400);
+  const uint32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return (int64_t)era * 146097 + (int64_t)doe - 719468;
+}
+
+// Year of a day count since 1970-01-01
+constexpr int32_t tzYearFromDays(int64_t z) {
+  z += 719468;
+  const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const uint32_t doe = (uint32_t)(z - era * 146097);
+  const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const uint32_t mp = (5 * doy + 2) / 153;
+  return (int32_t)(yoe + era * 400) + (mp >= 10);
+}
+
+struct TzRule {
+  bool valid;       // false: not a supported POSIX TZ string
+  bool hasDst;
+  int32_t stdOffset;   // seconds east of UTC
+  int32_t dstOffset;
+  TzDate start;     // standard -> DST, in standard local time
+  TzDate end;       // DST -> standard, in DST local time
+
+  // Offset east of UTC at `utc`, given the transitions of its year
+  constexpr int32_t offsetAt(int64_t utc, const TzYear &y) const {
+    if (!hasDst) return stdOffset;
+    bool dst = y.dstStart < y.dstEnd ? (utc >= y.dstStart && utc < y.dstEnd)
+                                     : (utc >= y.dstStart || utc < y.dstEnd);   // southern hemisphere
+    return dst ? dstOffset : stdOffset;
+  }
+
+  constexpr TzYear transitions(int32_t year) const {
+    TzYear y = {tzDaysFromCivil(year, 1, 1) * 86400, tzDaysFromCivil(year + 1, 1, 1) * 86400, 0, 0};
+    if (hasDst) {
+      y.dstStart = localInstant(year, start) - stdOffset;
+      y.dstEnd = localInstant(year, end) - dstOffset;
+    }
+    return y;
+  }
+
+  // Local seconds since the epoch of a transition date in `year`
+  static constexpr int64_t localInstant(int32_t year, const TzDate &d) {
+    int64_t first = tzDaysFromCivil(year, d.month, 1);
+    int64_t next = d.month == 12 ? tzDaysFromCivil(year + 1, 1, 1) : tzDaysFromCivil(year, d.month + 1, 1);
+    int32_t firstWday = (int32_t)((first % 7 + 11) % 7);   // 1970-01-01 was a Thursday
+    int64_t day = first + (d.wday - firstWday + 7) % 7 + (int64_t)(d.week - 1) * 7;
+    while (day >= next) day -= 7;   // week 5 = last occurrence in the month
+    return day * 86400 + d.time_s;
+  }
+};
+
+// ---------------------------------------------------------------------
+// constexpr parser for "std offset [dst [offset] ,Mm.w.d[/time],Mm.w.d[/time]]"
+// ---------------------------------------------------------------------
+namespace tz_detail {
+
+struct Cursor {
+  std::string_view s;
+  size_t i;
+  bool ok;
+
+  constexpr char peek() const { return i < s.size() ? s[i] : '\0'; }
+  constexpr bool eat(char c) {
+    if (peek() != c) return false;
+    i++;
+    return true;
+  }
+  constexpr int32_t number() {
+    if (peek() < '0' || peek() > '9') ok = false;
+    int32_t v = 0;
+    while (peek() >= '0' && peek() <= '9') v = v * 10 + (s[i++] - '0');
+    return v;
+  }
+  constexpr void name() {
+    size_t from = i;
+    if (eat('<')) {
+      while (peek() && peek() != '>') i++;
+      if (!eat('>')) ok = false;
+    } else {
+      while ((peek() >= 'A' && peek() <= 'Z') || (peek() >= 'a' && peek() <= 'z')) i++;
+    }
+    if (i - from < 3) ok = false;
+  }
+  // [+-]hh[:mm[:ss]] in seconds
+  constexpr int32_t hms() {
+    int32_t sign = 1;
+    if (eat('-')) sign = -1;
+    else eat('+');
+    int32_t v = number() * 3600;
+    if (eat(':')) v += number() * 60;
+    if (eat(':')) v += number();
+    return sign * v;
+  }
+  constexpr TzDate date() {
+    TzDate d = {0, 0, 0, 2 * 3600};
+    if (!eat('M')) {   // Jn and n forms are not used by the table
+      ok = false;
+      return d;
+    }
+    d.month = (uint8_t)number();
+    if (!eat('.')) ok = false;
+    d.week = (uint8_t)number();
+    if (!eat('.')) ok = false;
+    d.wday = (uint8_t)number();
+    if (eat('/')) d.time_s = hms();
+    if (d.month < 1 || d.month > 12 || d.week < 1 || d.week > 5 || d.wday > 6) ok = false;
+    return d;
+  }
+};
+
+} // namespace tz_detail
+
+constexpr TzRule tzCompile(std::string_view posix) {
+  tz_detail::Cursor c = {posix, 0, true};
+  TzRule r = {false, false, 0, 0, {}, {}};
+  c.name();
+  r.stdOffset = -c.hms();   // POSIX offsets are west of UTC
+  r.dstOffset = r.stdOffset;
+  if (c.peek()) {
+    c.name();
+    r.hasDst = true;
+    r.dstOffset = r.stdOffset + 3600;
+    if (c.peek() && c.peek() != ',') r.dstOffset = -c.hms();
+    if (!c.eat(',')) c.ok = false;
+    r.start = c.date();
+    if (!c.eat(',')) c.ok = false;
+    r.end = c.date();
+  }
+  r.valid = c.ok && c.i == posix.size();
+  return r;
+}
+
+} // namespace ED_SNTP
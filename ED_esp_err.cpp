@@ -8,6 +8,7 @@ const char* ED_err_to_name(esp_err_t err) {
         case ESP_ERR_SOCKET_BIND_FAILED:   return "ESP_ERR_SOCKET_BIND_FAILED";
         case ESP_ERR_SOCKET_LISTEN_FAILED: return "ESP_ERR_SOCKET_LISTEN_FAILED";
         case ESP_ERR_SOCKET_ACCEPT_FAILED: return "ESP_ERR_SOCKET_ACCEPT_FAILED";
+        case ESP_ERR_I2C_QUARANTINED:      return "ESP_ERR_I2C_QUARANTINED";
         default: return esp_err_to_name(err);  // fallback to ESP-IDF
     }
 };
\ No newline at end of file
@@ -70,6 +70,8 @@ CUSTOM ERRORS for ED series projects
 #define ESP_ERR_SOCKET_LISTEN_FAILED (ED_ERR_NET_BASE + 3)
 #define ESP_ERR_SOCKET_ACCEPT_FAILED (ED_ERR_NET_BASE + 4)
 
+#define ESP_ERR_I2C_QUARANTINED      (ED_ERR_SENSOR_BASE + 1) //I2C device failing, calls rejected until a background probe succeeds
+
 // custom_errors.c
 
 const char* ED_err_to_name(esp_err_t err) ;
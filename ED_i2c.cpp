@@ -1,207 +1,391 @@
-#include "ed_i2c.h"
+#include "ED_i2c.h"
+#include "ED_i2c_regcache.h"
+#include "ED_i2c_trace.h"
 #include "esp_log.h"
 #include "esp_check.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/gpio.h"
-#include "driver/periph_ctrl.h"
-#include "soc/periph_defs.h"
-#include "rom/ets_sys.h"
+#include "esp_timer.h"
 #include <cstring>
-#include <vector>
+#include <new>
+#if !CONFIG_IDF_TARGET_LINUX
+#include "ED_i2c_backend_esp.h"
+#endif
 
 static const char *TAG = "ed_i2c";
 
-#define I2C_MAX_RETRY_ATTEMPTS   3 //  -1:infinite, but obviously not compatible with multiple devices
-#define I2C_BASE_RETRY_DELAY_MS   200
-#define I2C_MAX_RETRY_DELAY_MS    2000
-#define PER_DEVICE_RETRY_LIMIT    3
 #define POST_CLEAR_DELAY_MS       50
+#define I2C_LADDER_PROBE_TMO_MS   5    // bus health check after each recovery tier
+#define I2C_BATCH_MAX_BURST       32   // bytes merged into one auto-increment transfer
+#define I2C_LOCK_TMO_MS           1000 // default wait for the bus lock
+#define I2C_REPLAY_TMO_MS         20   // per register write of a configuration replay
 
 // ---------------------------------------------------------------------
-// 9‑clock bus clear + STOP condition
-// ---------------------------------------------------------------------
-static void i2c_bus_clear(gpio_num_t sda, gpio_num_t scl) {
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << sda) | (1ULL << scl),
-        .mode = GPIO_MODE_OUTPUT_OD,
-        .pull_up_en = GPIO_PULLUP_ENABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    gpio_config(&io_conf);
-
-    gpio_set_level(sda, 1);
-    for (int i = 0; i < 9; i++) {
-        gpio_set_level(scl, 0);
-        esp_rom_delay_us(5);
-        gpio_set_level(scl, 1);
-        esp_rom_delay_us(5);
-    }
-    gpio_set_level(sda, 0);
-    esp_rom_delay_us(5);
-    gpio_set_level(scl, 1);
-    esp_rom_delay_us(5);
-    gpio_set_level(sda, 1);
-    esp_rom_delay_us(5);
+I2CBus::I2CBus(I2CBackend *backend, i2c_port_t port, uint32_t freq, bool owns_backend)
+    : m_port(port), m_freq(freq), m_status(ESP_OK), m_backend(backend), m_owns_backend(owns_backend), m_trace(nullptr),
+      m_arbiter(), m_lock_timeout_ms(I2C_LOCK_TMO_MS), m_adaptive(false), m_top_speed(0),
+      m_slots(), m_stats(), m_stats_start_us(esp_timer_get_time()), m_stats_seq(0),
+      m_dev_metrics(), m_dev_metrics_used(0), m_recovery(),
+      m_present(), m_seen(), m_scan_tmo_ms(0),
+      m_queue(nullptr), m_worker(nullptr), m_worker_exit(nullptr), m_worker_stopping(false), m_submitting(0),
+      m_probe_task(nullptr), m_probe_exit(nullptr), m_probe_stop(false)
+{
+    for (DeviceSlot &s : m_slots) s.metrics = NO_METRICS;
+    m_status = m_backend ? m_backend->open() : ESP_ERR_NO_MEM;
+    if (m_status != ESP_OK)
+        ESP_LOGE(TAG, "port %d: cannot open the bus (%s)", (int)m_port, esp_err_to_name(m_status));
 }
 
-// ---------------------------------------------------------------------
+#if !CONFIG_IDF_TARGET_LINUX
 I2CBus::I2CBus(i2c_port_t port, gpio_num_t sda, gpio_num_t scl, uint32_t freq)
-    : m_port(port), m_sda(sda), m_scl(scl), m_freq(freq), m_bus_handle(nullptr)
-{
-    i2c_master_bus_config_t bus_cfg = {
-        .i2c_port = port,
-        .sda_io_num = sda,
-        .scl_io_num = scl,
-        .clk_source = I2C_CLK_SRC_DEFAULT,
-        .glitch_ignore_cnt = 7,
-        .flags = { .enable_internal_pullup = true, .allow_pd = false },
-    };
-    ESP_ERROR_CHECK(i2c_new_master_bus(&bus_cfg, &m_bus_handle));
-}
+    : I2CBus(new (std::nothrow) I2CEspBackend(port, sda, scl), port, freq, true) {}
+#endif
+
+I2CBus::I2CBus(I2CBackend &backend, uint32_t freq, i2c_port_t port)
+    : I2CBus(&backend, port, freq, false) {}
 
 I2CBus::~I2CBus() {
-    for (auto &p : m_devices) i2c_master_bus_rm_device(p.second);
-    m_devices.clear();
-    if (m_bus_handle) i2c_del_master_bus(m_bus_handle);
+    stop_worker();
+    if (m_probe_task) {
+        m_probe_stop = true;
+        xTaskNotifyGive(m_probe_task);
+        xSemaphoreTake(m_probe_exit, portMAX_DELAY);
+        vSemaphoreDelete(m_probe_exit);
+    }
+    if (m_backend) m_backend->close();
+    if (m_trace) {
+        m_backend = m_trace->m_inner;
+        m_trace->m_inner = nullptr;
+    }
+    if (m_owns_backend) delete m_backend;
 }
 
-esp_err_t I2CBus::register_recovery_callback(uint8_t addr, std::function<esp_err_t(void)> cb) {
-    if (!cb) return ESP_ERR_INVALID_ARG;
-    m_recovery_callbacks[addr] = cb;
-    m_failure_count[addr] = 0;
+esp_err_t I2CBus::register_recovery_callback(uint8_t addr, I2CRecoveryCallback cb) {
+    if (!cb || addr >= I2C_ADDR_SLOTS) return ESP_ERR_INVALID_ARG;
+    I2CBusLock lock(*this);
+    if (lock.status() != ESP_OK) return lock.status();
+    m_slots[addr].recovery = cb;
+    m_slots[addr].failures = 0;
     return ESP_OK;
 }
 
-esp_err_t I2CBus::get_device(uint8_t addr, i2c_master_dev_handle_t *dev) {
-    if (!m_bus_handle) return ESP_ERR_INVALID_STATE;
-    auto it = m_devices.find(addr);
-    if (it != m_devices.end()) {
-        *dev = it->second;
-        return ESP_OK;
-    }
-    i2c_device_config_t dev_cfg = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = addr,
-        .scl_speed_hz = m_freq,
-        .scl_wait_us = 0,
-        .flags = { .disable_ack_check = false },
-    };
-    i2c_master_dev_handle_t new_dev;
-    esp_err_t err = i2c_master_bus_add_device(m_bus_handle, &dev_cfg, &new_dev);
+esp_err_t I2CBus::attach_reg_cache(uint8_t addr, I2CRegCache *cache) {
+    if (!cache || addr >= I2C_ADDR_SLOTS) return ESP_ERR_INVALID_ARG;
+    I2CBusLock lock(*this);
+    if (lock.status() != ESP_OK) return lock.status();
+    if (m_slots[addr].cache) return ESP_ERR_INVALID_STATE;
+    m_slots[addr].cache = cache;
+    return ESP_OK;
+}
+
+void I2CBus::detach_reg_cache(uint8_t addr, I2CRegCache *cache) {
+    if (addr < I2C_ADDR_SLOTS && m_slots[addr].cache == cache) m_slots[addr].cache = nullptr;
+}
+
+esp_err_t I2CBus::get_device(uint8_t addr) {
+    if (m_status != ESP_OK) return m_status;
+    if (!m_backend->is_open()) return ESP_ERR_INVALID_STATE;
+    if (addr >= I2C_ADDR_SLOTS) return ESP_ERR_INVALID_ARG;
+    DeviceSlot &slot = m_slots[addr];
+    if (slot.attached) return ESP_OK;
+    esp_err_t err = m_backend->add_device(addr, device_hz(slot));
     if (err == ESP_OK) {
-        m_devices[addr] = new_dev;
-        *dev = new_dev;
+        slot.attached = true;
+        if (!slot.known) assign_metrics(addr);
+        slot.known = true;
     }
     return err;
 }
 
 // ---------------------------------------------------------------------
-// Full hardware bus reset
+// Driver teardown / rebuild, shared by the two top recovery tiers.
+// Slots keep `known`, so every device in use is attached again.
 // ---------------------------------------------------------------------
-esp_err_t I2CBus::recover_bus() {
-    // Save addresses
-    std::vector<uint8_t> addrs;
-    for (auto &p : m_devices) addrs.push_back(p.first);
-
-    // Bus clear
-    i2c_bus_clear(m_sda, m_scl);
-
-    // Delete bus
-    for (auto &p : m_devices) i2c_master_bus_rm_device(p.second);
-    m_devices.clear();
-    if (m_bus_handle) {
-        i2c_del_master_bus(m_bus_handle);
-        m_bus_handle = nullptr;
+void I2CBus::teardown_driver() {
+    m_backend->close();
+    for (DeviceSlot &s : m_slots) s.attached = false;
+}
+
+esp_err_t I2CBus::rebuild_driver() {
+    esp_err_t err = m_backend->open();
+    if (err != ESP_OK) return err;
+
+    for (uint8_t a = 0; a < I2C_ADDR_SLOTS; a++) {
+        if (m_slots[a].known && m_backend->add_device(a, device_hz(m_slots[a])) == ESP_OK)
+            m_slots[a].attached = true;
     }
+    return ESP_OK;
+}
+
+// ---------------------------------------------------------------------
+// Full hardware bus reset (top tier of the recovery ladder)
+// ---------------------------------------------------------------------
+esp_err_t I2CBus::recover_bus() {
+    teardown_driver();
 
-    // Hardware peripheral reset
-    periph_module_reset(PERIPH_I2C0_MODULE);
-    esp_rom_delay_us(100);
-    periph_module_enable(PERIPH_I2C0_MODULE);
+    // Bus clear, pins are free now that the driver is gone
+    m_backend->bus_clear();
+
+    // Hardware peripheral reset, on the module that backs this port
+    m_backend->periph_reset();
+    record_bus_reset();
     vTaskDelay(pdMS_TO_TICKS(POST_CLEAR_DELAY_MS));
 
-    // Re‑create bus
-    i2c_master_bus_config_t bus_cfg = {
-        .i2c_port = m_port,
-        .sda_io_num = m_sda,
-        .scl_io_num = m_scl,
-        .clk_source = I2C_CLK_SRC_DEFAULT,
-        .glitch_ignore_cnt = 7,
-        .flags = { .enable_internal_pullup = true, .allow_pd = false },
-    };
-    esp_err_t err = i2c_new_master_bus(&bus_cfg, &m_bus_handle);
+    esp_err_t err = rebuild_driver();
     if (err != ESP_OK) return err;
 
-    // Re‑add devices
-    for (uint8_t a : addrs) {
-        i2c_device_config_t dev_cfg = {
-            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-            .device_address = a,
-            .scl_speed_hz = m_freq,
-            .scl_wait_us = 0,
-            .flags = { .disable_ack_check = false },
-        };
-        i2c_master_dev_handle_t new_dev;
-        if (i2c_master_bus_add_device(m_bus_handle, &dev_cfg, &new_dev) == ESP_OK)
-            m_devices[a] = new_dev;
+    // Replay cached configurations, then execute recovery callbacks.
+    // Quarantined devices are restored when their breaker closes.
+    for (uint8_t a = 0; a < I2C_ADDR_SLOTS; a++) {
+        DeviceSlot &s = m_slots[a];
+        s.failures = 0;
+        if (s.breaker != I2CBreakerState::CLOSED || (!s.cache && !s.recovery)) continue;
+        err = restore_device(a);
+        if (err != ESP_OK)
+            ESP_LOGW(TAG, "0x%02X: not restored after bus reset (%s)", a, esp_err_to_name(err));
     }
 
-    // Execute recovery callbacks
-    for (auto &p : m_recovery_callbacks) p.second();
-    for (auto &p : m_failure_count) p.second = 0;
-
     return ESP_OK;
 }
 
 // ---------------------------------------------------------------------
-// Retry macro with per‑device soft recovery then full reset
+// Device restore after a recovery: cache replay on raw writes, then the
+// recovery callback, whose calls get a single attempt (see run_retry). A
+// device that still fails is reported to the caller instead of recovering
+// again. Bus lock held.
+// ---------------------------------------------------------------------
+esp_err_t I2CBus::raw_write(uint8_t addr, const uint8_t *data, size_t len) {
+    esp_err_t err = get_device(addr);
+    if (err != ESP_OK) return err;
+    int64_t t0 = esp_timer_get_time();
+    err = m_backend->transmit(addr, data, len, I2C_REPLAY_TMO_MS);
+    record_attempt(m_slots[addr], (uint32_t)(esp_timer_get_time() - t0), len, err == ESP_OK);
+    note_presence(addr, err);
+    return err;
+}
+
+esp_err_t I2CBus::restore_device(uint8_t addr) {
+    DeviceSlot &s = m_slots[addr];
+    esp_err_t err = ESP_OK;
+    bool nested = s.recovering;
+    s.recovering = true;   // the callback's own calls must not recover again
+    if (s.cache) err = s.cache->replay(true);
+    if (s.recovery) {
+        esp_err_t cb_err = s.recovery();
+        if (err == ESP_OK) err = cb_err;
+    }
+    s.recovering = nested;
+    return err;
+}
+
+// ---------------------------------------------------------------------
+// Recovery ladder
+// DEVICE_SOFT   per-device: cache replay + recovery callback, bus untouched
+// BUS_CLEAR     controller-driven 9 clocks + STOP, handles kept
+// DRIVER_REINIT delete/re-create the master bus and device handles
+// PERIPH_RESET  DRIVER_REINIT plus peripheral reset and settle delay
+// A tier succeeds when the bus answers again: the failing device ACKs or
+// NACKs cleanly. Only then does escalation stop.
+// ---------------------------------------------------------------------
+void I2CBus::record_tier(I2CRecoveryTier tier, uint8_t addr, int64_t t0, bool ok) {
+    I2CRecoveryTierStats &st = m_recovery.tier[(int)tier];
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    st.attempts++;
+    if (ok) st.successes++;
+    st.total_us += us;
+    if (us > st.max_us) st.max_us = us;
+    if (m_trace) m_trace->event(I2CTraceOp::RECOVERY, addr, ok ? ESP_OK : ESP_FAIL, (uint16_t)tier, us);
+}
+
+bool I2CBus::bus_answers(uint8_t addr) {
+    if (!m_backend->is_open()) return false;
+    esp_err_t err = m_backend->probe(addr, I2C_LADDER_PROBE_TMO_MS);
+    return err == ESP_OK || err == ESP_ERR_NOT_FOUND;
+}
+
+bool I2CBus::soft_recover(uint8_t addr) {
+    DeviceSlot &s = m_slots[addr];
+    if (!s.cache && !s.recovery) return false;
+
+    int64_t t0 = esp_timer_get_time();
+    bool ok = restore_device(addr) == ESP_OK;
+    record_tier(I2CRecoveryTier::DEVICE_SOFT, addr, t0, ok);
+    if (ok && s.metrics != NO_METRICS)
+        m_dev_metrics[s.metrics].soft_recoveries.fetch_add(1, std::memory_order_relaxed);
+    return ok;
+}
+
+esp_err_t I2CBus::recover_ladder(uint8_t addr) {
+    if (m_slots[addr].metrics != NO_METRICS)
+        m_dev_metrics[m_slots[addr].metrics].bus_recoveries.fetch_add(1, std::memory_order_relaxed);
+
+    int64_t t0 = esp_timer_get_time();
+    bool ok = m_backend->bus_reset() == ESP_OK && bus_answers(addr);
+    record_tier(I2CRecoveryTier::BUS_CLEAR, addr, t0, ok);
+    if (ok) return ESP_OK;
+
+    t0 = esp_timer_get_time();
+    teardown_driver();
+    m_backend->bus_clear();
+    ok = rebuild_driver() == ESP_OK && bus_answers(addr);
+    record_tier(I2CRecoveryTier::DRIVER_REINIT, addr, t0, ok);
+    if (ok) return ESP_OK;
+
+    t0 = esp_timer_get_time();
+    ok = recover_bus() == ESP_OK && bus_answers(addr);
+    record_tier(I2CRecoveryTier::PERIPH_RESET, addr, t0, ok);
+    if (!ok) ESP_LOGE(TAG, "port %d: bus still not answering after full reset", (int)m_port);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+void I2CBus::get_recovery_stats(I2CRecoveryStats *out) const {
+    if (out) *out = m_recovery;
+}
+
+void I2CBus::log_recovery_stats() const {
+    static const char *names[I2C_RECOVERY_TIERS] = {"device soft", "bus clear", "driver reinit", "periph reset"};
+    for (int i = 0; i < I2C_RECOVERY_TIERS; i++) {
+        const I2CRecoveryTierStats &st = m_recovery.tier[i];
+        if (st.attempts == 0) continue;
+        ESP_LOGI(TAG, "%-13s: %lu/%lu ok, avg %llu us, max %lu us", names[i],
+                 (unsigned long)st.successes, (unsigned long)st.attempts,
+                 (unsigned long long)(st.total_us / st.attempts), (unsigned long)st.max_us);
+    }
+}
+
+// ---------------------------------------------------------------------
+// Pause of a backoff policy. The bus lock is released meanwhile, unless the
+// caller holds it across calls with an I2CBusLock.
 // ---------------------------------------------------------------------
-#define I2C_RETRY_WITH_RECOVERY(expr, addr) \
-    do { \
-        int _attempt = 0, _delay = I2C_BASE_RETRY_DELAY_MS; \
-        esp_err_t _err; \
-        while (1) { \
-            i2c_master_dev_handle_t _dev; \
-            _err = get_device(addr, &_dev); \
-            if (_err == ESP_OK) { \
-                _err = (expr); \
-                if (_err == ESP_OK) { \
-                    m_failure_count[addr] = 0; \
-                    return ESP_OK; \
-                } \
-            } \
-            int &fcnt = m_failure_count[addr]; \
-            fcnt++; \
-            bool per_ok = false; \
-            auto it = m_recovery_callbacks.find(addr); \
-            if (it != m_recovery_callbacks.end() && fcnt <= PER_DEVICE_RETRY_LIMIT) { \
-                if (it->second() == ESP_OK) { per_ok = true; fcnt = 0; continue; } \
-            } \
-            if (!per_ok && fcnt > PER_DEVICE_RETRY_LIMIT) { \
-                recover_bus(); \
-                fcnt = 0; \
-            } \
-            _attempt++; \
-            if (I2C_MAX_RETRY_ATTEMPTS > 0 && _attempt >= I2C_MAX_RETRY_ATTEMPTS) return _err; \
-            vTaskDelay(pdMS_TO_TICKS(_delay)); \
-            _delay = (_delay * 2 > I2C_MAX_RETRY_DELAY_MS) ? I2C_MAX_RETRY_DELAY_MS : _delay * 2; \
-        } \
-    } while(0)
+esp_err_t I2CBus::retry_pause(uint32_t ms, int64_t deadline_us) {
+    int left = remaining_ms(deadline_us);
+    if (left >= 0 && (uint32_t)left <= ms) return ESP_ERR_TIMEOUT;   // would wake up past the deadline
+    m_arbiter.release();
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+    vTaskDelay(ticks ? ticks : 1);
+    uint32_t tmo = m_lock_timeout_ms;
+    return m_arbiter.acquire(I2C_PRIO_OF_TASK, tmo == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(tmo));
+}
+
+esp_err_t I2CBus::do_write(uint8_t addr, const uint8_t *data, size_t len, int64_t deadline_us) {
+    return run_retry<I2CRetryDefault>(addr, deadline_us, len, [&](int tmo) {
+        return m_backend->transmit(addr, data, len, tmo);
+    });
+}
+esp_err_t I2CBus::do_read(uint8_t addr, uint8_t *data, size_t len, int64_t deadline_us) {
+    return run_retry<I2CRetryDefault>(addr, deadline_us, len, [&](int tmo) {
+        return m_backend->receive(addr, data, len, tmo);
+    });
+}
+esp_err_t I2CBus::do_write_then_read(uint8_t addr, const uint8_t *wdata, size_t wlen,
+                                     uint8_t *rdata, size_t rlen, int64_t deadline_us) {
+    return run_retry<I2CRetryDefault>(addr, deadline_us, wlen + rlen, [&](int tmo) {
+        return m_backend->transmit_receive(addr, wdata, wlen, rdata, rlen, tmo);
+    });
+}
 
 esp_err_t I2CBus::write(uint8_t addr, const uint8_t *data, size_t len) {
-    I2C_RETRY_WITH_RECOVERY(i2c_master_transmit(_dev, data, len, -1), addr);
+    return do_write(addr, data, len, 0);
 }
 esp_err_t I2CBus::read(uint8_t addr, uint8_t *data, size_t len) {
-    I2C_RETRY_WITH_RECOVERY(i2c_master_receive(_dev, data, len, -1), addr);
+    return do_read(addr, data, len, 0);
 }
 esp_err_t I2CBus::write_then_read(uint8_t addr, const uint8_t *wdata, size_t wlen, uint8_t *rdata, size_t rlen) {
-    I2C_RETRY_WITH_RECOVERY(i2c_master_transmit_receive(_dev, wdata, wlen, rdata, rlen, -1), addr);
+    return do_write_then_read(addr, wdata, wlen, rdata, rlen, 0);
+}
+
+// ---------------------------------------------------------------------
+// Batched register transfers
+// ---------------------------------------------------------------------
+static bool batch_mergeable(const I2CRegOp &a, const I2CRegOp &b) {
+    return a.addr == b.addr && a.dir == b.dir && (unsigned)a.reg + a.len == b.reg;
+}
+
+// Runs the batch from *next on, one burst at a time, without retries.
+// *next only advances past bursts that completed, so a retry resumes there.
+// Only merged bursts are bounded by I2C_BATCH_MAX_BURST; a longer item runs on its own.
+esp_err_t I2CBus::run_batch(I2CRegOp *ops, size_t count, bool merge, size_t *next, int timeout_ms) {
+    uint8_t buf[I2C_BATCH_MAX_BURST + 1];
+    while (*next < count) {
+        size_t first = *next, last = first;
+        size_t total = ops[first].len;
+        while (merge && last + 1 < count && batch_mergeable(ops[last], ops[last + 1]) &&
+               total + ops[last + 1].len <= I2C_BATCH_MAX_BURST) {
+            total += ops[++last].len;
+        }
+
+        const I2CRegOp &op = ops[first];
+        esp_err_t err = get_device(op.addr);
+        if (err == ESP_OK) {
+            if (op.dir == I2CRegOp::Dir::READ) {
+                if (first == last) {
+                    err = m_backend->transmit_receive(op.addr, &op.reg, 1, op.data, op.len, timeout_ms);
+                } else {
+                    err = m_backend->transmit_receive(op.addr, &op.reg, 1, buf, total, timeout_ms);
+                    for (size_t k = first, off = 0; err == ESP_OK && k <= last; off += ops[k].len, k++)
+                        memcpy(ops[k].data, buf + off, ops[k].len);
+                }
+            } else if (op.len > I2C_BATCH_MAX_BURST) {
+                // Too long for the burst buffer: never merged, sent from the caller's buffer
+                err = m_backend->transmit_reg(op.addr, op.reg, op.data, op.len, timeout_ms);
+            } else {
+                buf[0] = op.reg;
+                for (size_t k = first, off = 1; k <= last; off += ops[k].len, k++)
+                    memcpy(buf + off, ops[k].data, ops[k].len);
+                err = m_backend->transmit(op.addr, buf, total + 1, timeout_ms);
+            }
+        }
+        for (size_t k = first; k <= last; k++) ops[k].status = err;
+        if (err != ESP_OK) return err;
+        *next = last + 1;
+    }
+    return ESP_OK;
+}
+
+// One device's run of consecutive items, ops[first..end), is a retry unit
+// charged to that device. Items it does not complete take its final error.
+esp_err_t I2CBus::do_batch(I2CRegOp *ops, size_t first, size_t end, bool merge) {
+    size_t next = first, bytes = 0;
+    for (size_t i = first; i < end; i++) bytes += ops[i].len;
+    esp_err_t err = run_retry<I2CRetryDefault>(ops[first].addr, 0, bytes, [&](int tmo) {
+        return run_batch(ops, end, merge, &next, tmo);
+    });
+    for (size_t i = next; err != ESP_OK && i < end; i++) ops[i].status = err;
+    return err;
+}
+
+esp_err_t I2CBus::transfer_batch(I2CRegOp *ops, size_t count, bool merge) {
+    if (!ops || count == 0) return ESP_ERR_INVALID_ARG;
+    esp_err_t err = ESP_OK;
+    for (size_t i = 0; i < count; i++) {
+        bool ok = ops[i].addr < I2C_ADDR_SLOTS && ops[i].data && ops[i].len > 0;
+        ops[i].status = ok ? ESP_ERR_NOT_FINISHED : ESP_ERR_INVALID_ARG;
+        if (!ok) err = ESP_ERR_INVALID_ARG;
+    }
+    if (err != ESP_OK) return err;   // reject the whole batch before touching the bus
+
+    I2CBusLock lock(*this);   // one bus session: other tasks wait for the whole batch
+    if (lock.status() != ESP_OK) {
+        for (size_t i = 0; i < count; i++) ops[i].status = lock.status();
+        return lock.status();
+    }
+    // A device that fails or is quarantined fails its own items only
+    for (size_t first = 0; first < count;) {
+        size_t end = first + 1;
+        while (end < count && ops[end].addr == ops[first].addr) end++;
+        esp_err_t dev_err = do_batch(ops, first, end, merge);
+        if (err == ESP_OK) err = dev_err;
+        first = end;
+    }
+    return err;
 }
 
 esp_err_t I2CBus::probe(uint8_t dev_addr, uint32_t timeout_ms) {
-    if (!m_bus_handle) return ESP_ERR_INVALID_STATE;
-    // i2c_master_probe returns ESP_OK if device ACKs within timeout
-    return i2c_master_probe(m_bus_handle, dev_addr, timeout_ms);
+    if (m_status != ESP_OK) return m_status;
+    I2CBusLock lock(*this);
+    if (lock.status() != ESP_OK) return lock.status();
+    if (!m_backend->is_open()) return ESP_ERR_INVALID_STATE;
+    esp_err_t err = m_backend->probe(dev_addr, (int)timeout_ms);
+    note_presence(dev_addr, err);
+    return err;
 }
\ No newline at end of file
@@ -1,17 +1,221 @@
 #ifndef ED_I2C_H
 #define ED_I2C_H
 
-#include "driver/i2c_master.h"
 #include "esp_err.h"
+#include "ED_esp_err.h"
+#include "ED_i2c_backend.h"
+#include "ED_i2c_lock.h"
+#include "ED_i2c_retry.h"
+#include "sdkconfig.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "driver/i2c_master.h"
 #include "driver/gpio.h"
-#include <map>
-#include <functional>
+#include "soc/soc_caps.h"
+#endif
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "ED_inplace_function.h"
+#include <atomic>
 #include <cstddef>
 
+#define I2C_ADDR_SLOTS  128   // one descriptor per 7-bit address
+#define I2C_GENERAL_CALL_ADDR  0x00
+
+// HP (main) I2C controllers; LP I2C ports, where present, are numbered after them
+#if CONFIG_IDF_TARGET_LINUX
+// Host build: no I2C hardware, only backends passed to I2CBus(backend, ...)
+typedef int i2c_port_t;
+typedef int gpio_num_t;
+#define I2C_NUM_0          0
+#define I2C_HP_PORT_COUNT  1
+#elif defined(SOC_HP_I2C_NUM)
+#define I2C_HP_PORT_COUNT  SOC_HP_I2C_NUM
+#else
+#define I2C_HP_PORT_COUNT  SOC_I2C_NUM
+#endif
+
+/// Per-device recovery callback. Stored inline in the address table (no heap):
+/// captures must fit in two pointers, e.g. `[&dev]` or `[this]`.
+using I2CRecoveryCallback = InplaceFunction<esp_err_t(void)>;
+
+// ---------------------------------------------------------------------
+// Asynchronous transactions
+// ---------------------------------------------------------------------
+
+/**
+ * @brief Completion handle for an asynchronous transaction.
+ * Owned by the caller (stack or static storage), no heap. A future may be
+ * reused once the previous transaction bound to it has completed.
+ */
+class I2CFuture {
+public:
+    I2CFuture();
+    ~I2CFuture();
+    I2CFuture(const I2CFuture &) = delete;
+    I2CFuture &operator=(const I2CFuture &) = delete;
+
+    /// Blocks until the transaction completes; ESP_ERR_TIMEOUT if `ticks` elapse first.
+    esp_err_t wait(TickType_t ticks = portMAX_DELAY);
+    bool      done() const { return m_done; }
+    esp_err_t result() const { return m_result; }
+
+private:
+    friend class I2CBus;
+    void reset();
+    void complete(esp_err_t err);
+
+    StaticSemaphore_t   m_sem_buf;
+    SemaphoreHandle_t   m_sem;
+    volatile esp_err_t  m_result;
+    volatile bool       m_done;
+};
+
+/// Completion callback, runs in the bus worker task. Keep it short.
+typedef void (*i2c_done_cb_t)(esp_err_t err, void *arg);
+
+struct I2CTransaction {
+    enum class Op : uint8_t { WRITE, READ, WRITE_READ };
+
+    Op             op         = Op::WRITE;
+    uint8_t        addr       = 0;
+    const uint8_t *wdata      = nullptr;   // must stay valid until completion
+    size_t         wlen       = 0;
+    uint8_t       *rdata      = nullptr;   // must stay valid until completion
+    size_t         rlen       = 0;
+    uint32_t       timeout_ms = 0;         // deadline from submission, retries included; 0 = none
+    i2c_done_cb_t  cb         = nullptr;   // optional
+    void          *cb_arg     = nullptr;
+    I2CFuture     *future     = nullptr;   // optional
+};
+
+/// One register access inside a batch, see I2CBus::transfer_batch()
+struct I2CRegOp {
+    enum class Dir : uint8_t { READ, WRITE };
+
+    Dir        dir;
+    uint8_t    addr;     // 7-bit device address
+    uint8_t    reg;      // first register
+    uint8_t   *data;     // READ: destination, WRITE: source
+    size_t     len;
+    esp_err_t  status;   // per-item result, ESP_ERR_NOT_FINISHED if the batch was rejected
+};
+
+/// Bus-level counters, see I2CBus::get_stats()
+struct I2CBusStats {
+    uint32_t transactions;   // successful transactions
+    uint32_t failures;       // failed attempts (a retried transaction may count several)
+    uint32_t bus_resets;     // full recover_bus() runs
+    uint64_t bytes;          // payload bytes moved by successful transactions
+    uint64_t busy_us;        // time spent inside the IDF driver
+    uint64_t window_us;      // time since the counters were (re)started
+
+    float utilization() const { return window_us ? (float)busy_us * 100.0f / (float)window_us : 0.0f; }
+    float bytes_per_s() const { return window_us ? (float)bytes * 1e6f / (float)window_us : 0.0f; }
+};
+
+// Per-device metrics are kept for the first I2C_METRICS_MAX_DEVICES addresses
+// used on a bus; later ones only count in the bus totals.
+#define I2C_METRICS_MAX_DEVICES  16
+// Latency histogram: bucket i counts attempts taking [2^i, 2^(i+1)) µs,
+// bucket 0 also holds < 1 µs, the last bucket is open-ended (≥ 32 ms).
+#define I2C_LATENCY_BUCKETS      16
+
+struct I2CDeviceMetrics {
+    uint8_t  addr;
+    uint32_t transactions;      // successful transactions
+    uint32_t failures;          // failed attempts
+    uint32_t bytes;             // payload bytes of successful transactions (wraps)
+    uint32_t soft_recoveries;   // successful cache replay / recovery callback runs
+    uint32_t bus_recoveries;    // recovery ladder runs triggered by this device
+    uint32_t scl_hz;            // SCL speed the device currently runs at
+    uint32_t latency_hist[I2C_LATENCY_BUCKETS];
+};
+
+struct I2CMetricsSnapshot {
+    I2CBusStats      bus;
+    size_t           device_count;
+    I2CDeviceMetrics devices[I2C_METRICS_MAX_DEVICES];
+};
+
+/**
+ * @brief Per-device circuit breaker.
+ * CLOSED: normal. OPEN: the device exhausted its retries; calls fail fast with
+ * ESP_ERR_I2C_QUARANTINED while a background task probes it with growing
+ * backoff. HALF_OPEN: a probe is in flight.
+ */
+enum class I2CBreakerState : uint8_t { CLOSED, OPEN, HALF_OPEN };
+
+struct I2CBreakerInfo {
+    I2CBreakerState state;
+    uint8_t         failures;      // consecutive failed attempts
+    uint16_t        trips;         // times the breaker opened
+    uint32_t        backoff_ms;    // current probe interval
+    uint32_t        retry_in_ms;   // time to next probe, 0 if CLOSED
+    esp_err_t       last_error;    // error that opened the breaker
+};
+
+/// Recovery ladder tiers, cheapest first
+enum class I2CRecoveryTier : uint8_t { DEVICE_SOFT, BUS_CLEAR, DRIVER_REINIT, PERIPH_RESET };
+#define I2C_RECOVERY_TIERS  4
+
+struct I2CRecoveryTierStats {
+    uint32_t attempts;
+    uint32_t successes;
+    uint64_t total_us;
+    uint32_t max_us;
+};
+
+struct I2CRecoveryStats {
+    I2CRecoveryTierStats tier[I2C_RECOVERY_TIERS];   // indexed by I2CRecoveryTier
+};
+
+// One bit per 7-bit address
+struct I2CAddrMap {
+    uint32_t bits[I2C_ADDR_SLOTS / 32];
+
+    bool   test(uint8_t addr) const { return addr < I2C_ADDR_SLOTS && (bits[addr >> 5] >> (addr & 31)) & 1u; }
+    void   set(uint8_t addr, bool on = true) {
+        if (addr >= I2C_ADDR_SLOTS) return;
+        if (on) bits[addr >> 5] |= 1u << (addr & 31);
+        else    bits[addr >> 5] &= ~(1u << (addr & 31));
+    }
+    void   clear() { for (uint32_t &w : bits) w = 0; }
+    size_t count() const {
+        size_t n = 0;
+        for (uint32_t w : bits) n += __builtin_popcount(w);
+        return n;
+    }
+    // Addresses first..last inclusive
+    static I2CAddrMap range(uint8_t first, uint8_t last) {
+        I2CAddrMap m = {};
+        for (unsigned a = first; a <= last && a < I2C_ADDR_SLOTS; a++) m.set((uint8_t)a);
+        return m;
+    }
+};
+
+class I2CRegCache;
+class I2CBusLock;
+class I2CTrace;
+class I2CGroup;
+
 class I2CBus {
 public:
+#if !CONFIG_IDF_TARGET_LINUX
+    // IDF i2c_master driver on an HP port
     I2CBus(i2c_port_t port, gpio_num_t sda, gpio_num_t scl, uint32_t freq);
+#endif
+    // Any other transport, e.g. I2CSimBackend. `port` only labels the bus.
+    I2CBus(I2CBackend &backend, uint32_t freq, i2c_port_t port = I2C_NUM_0);
     ~I2CBus();
+    I2CBus(const I2CBus &) = delete;
+    I2CBus &operator=(const I2CBus &) = delete;
+
+    // Result of construction. A bus whose controller could not be opened
+    // (bad port or pins, no memory) answers every call with this error.
+    esp_err_t status() const { return m_status; }
 
     esp_err_t write(uint8_t dev_addr, const uint8_t *data, size_t len);
     esp_err_t read(uint8_t dev_addr, uint8_t *data, size_t len);
@@ -20,21 +224,368 @@ public:
                               uint8_t *read_data, size_t read_len);
     esp_err_t probe(uint8_t dev_addr, uint32_t timeout_ms = 100);
 
-    esp_err_t register_recovery_callback(uint8_t dev_addr, std::function<esp_err_t(void)> callback);
+    // The same calls with a compile-time retry policy (ED_i2c_retry.h), e.g.
+    // write_then_read<I2CNoRetry>(...) for a read that must not wait for
+    // recovery. The calls above use I2CRetryDefault.
+    template <typename Policy>
+    esp_err_t write(uint8_t dev_addr, const uint8_t *data, size_t len);
+    template <typename Policy>
+    esp_err_t read(uint8_t dev_addr, uint8_t *data, size_t len);
+    template <typename Policy>
+    esp_err_t write_then_read(uint8_t dev_addr,
+                              const uint8_t *write_data, size_t write_len,
+                              uint8_t *read_data, size_t read_len);
+
+    // Single-pass discovery. Probes `candidates` (default 0x08-0x77) with a
+    // short timeout that only grows if a device stretches the clock; answers
+    // already known from the cache or from earlier transactions are reused
+    // unless `refresh` is set.
+    esp_err_t scan(I2CAddrMap *present, const I2CAddrMap *candidates = nullptr, bool refresh = false);
+    bool      is_present(uint8_t dev_addr) const { return m_present.test(dev_addr); }
+    void      invalidate_scan();
+
+    esp_err_t register_recovery_callback(uint8_t dev_addr, I2CRecoveryCallback callback);
+
+    // Arbitration between tasks: every call takes the bus lock for one
+    // transaction, at the caller's FreeRTOS priority; I2CBusLock holds it
+    // across calls. A call that cannot get the lock within the timeout
+    // (default 1000 ms, UINT32_MAX = forever) returns ESP_ERR_TIMEOUT.
+    void       set_lock_timeout(uint32_t timeout_ms);
+    void       get_lock_stats(I2CLockStats *out) const;
+    void       log_lock_stats() const;
+
+    // Adaptive per-device SCL speed. Each device starts at `max_hz` (0 = the
+    // fastest the chip supports), steps down the 1 MHz / 400 kHz / 100 kHz
+    // ladder after errors and periodically tries the next faster step again.
+    // Call before the bus is in use.
+    esp_err_t  enable_adaptive_speed(uint32_t max_hz = 0);
+    uint32_t   device_speed(uint8_t dev_addr) const;
+    // Data-integrity error found by a device driver (bad CRC/checksum):
+    // counted like a bus error by the speed adaptation
+    void       report_crc_error(uint8_t dev_addr);
+
+    esp_err_t  get_breaker(uint8_t dev_addr, I2CBreakerInfo *out) const;
+    void       reset_breaker(uint8_t dev_addr);
+    void       log_breakers() const;
+
+    void       get_recovery_stats(I2CRecoveryStats *out) const;
+    void       log_recovery_stats() const;
+
+    // Transaction trace (ED_i2c_trace.h): every backend operation, retry,
+    // recovery tier and breaker trip goes into `trace` until detached.
+    // The trace is not owned and must outlive the attachment.
+    esp_err_t  attach_trace(I2CTrace *trace);
+    esp_err_t  detach_trace();
+
+    i2c_port_t port() const { return m_port; }
+    uint32_t   freq() const { return m_freq; }
+    // Metrics: readers never block the transaction path
+    void       get_stats(I2CBusStats *out) const;
+    esp_err_t  get_device_metrics(uint8_t dev_addr, I2CDeviceMetrics *out) const;
+    void       get_metrics(I2CMetricsSnapshot *out) const;
+    void       log_metrics() const;
+    esp_err_t  reset_stats();   // ESP_ERR_TIMEOUT if the bus lock is not free in time
+
+    // Runs a list of register accesses back-to-back under one bus lock. Each
+    // run of consecutive items on one device is a retry/recovery unit of that
+    // device: a device that fails, or is quarantined, fails its own items
+    // and the batch goes on with the next one. Every item gets its status;
+    // the first error is returned. Adjacent items on the same device with
+    // contiguous registers are merged into a single auto-increment burst of
+    // up to I2C_BATCH_MAX_BURST bytes unless `merge` is false; a longer item
+    // runs on its own.
+    esp_err_t transfer_batch(I2CRegOp *ops, size_t count, bool merge = true);
+
+    // Asynchronous engine: one worker task per bus drains a bounded queue,
+    // so retries and recovery never run in the submitting task.
+    esp_err_t start_worker(size_t queue_len = 8, UBaseType_t priority = 10,
+                           BaseType_t core = tskNO_AFFINITY);
+    void      stop_worker();
+    esp_err_t submit(const I2CTransaction &t, TickType_t enqueue_wait = 0);
+    esp_err_t write_async(uint8_t dev_addr, const uint8_t *data, size_t len,
+                          I2CFuture *future, uint32_t timeout_ms = 0);
+    esp_err_t read_async(uint8_t dev_addr, uint8_t *data, size_t len,
+                         I2CFuture *future, uint32_t timeout_ms = 0);
+    esp_err_t write_then_read_async(uint8_t dev_addr,
+                                    const uint8_t *write_data, size_t write_len,
+                                    uint8_t *read_data, size_t read_len,
+                                    I2CFuture *future, uint32_t timeout_ms = 0);
 
 private:
-    esp_err_t get_device(uint8_t dev_addr, i2c_master_dev_handle_t *dev_handle);
+    // Flat per-address descriptor: O(1) lookup, nothing allocated per call
+    struct DeviceSlot {
+        bool                    attached;   // added to the backend since the last (re)open
+        I2CRecoveryCallback     recovery;
+        I2CRegCache            *cache;      // optional register shadow, replayed after a bus reset
+        uint8_t                 failures;   // consecutive failures
+        bool                    recovering; // being restored: its calls get one attempt, no recovery
+        bool                    known;      // handle to re-create after a bus reset
+        I2CBreakerState         breaker;
+        uint16_t                trips;
+        uint32_t                backoff_ms;
+        int64_t                 open_until_us;
+        esp_err_t               last_error;
+        uint8_t                 metrics;    // index in m_dev_metrics, NO_METRICS if none
+        // Adaptive SCL speed, see ED_i2c_speed.cpp
+        uint8_t                 speed;      // index in the speed ladder, 0 = fastest
+        uint8_t                 speed_score;// leaky error score at this speed
+        bool                    speed_trial;// just stepped up, one error steps back down
+        uint16_t                speed_ok;   // successes since the last change
+        uint32_t                speed_backoff_ms;
+        int64_t                 speed_next_up_us;
+    };
+
+    static constexpr uint8_t NO_METRICS = 0xFF;
+
+    // Relaxed atomics: exact per counter, no lock on either side
+    struct DeviceCounters {
+        std::atomic<uint32_t> transactions;
+        std::atomic<uint32_t> failures;
+        std::atomic<uint32_t> bytes;
+        std::atomic<uint32_t> soft_recoveries;
+        std::atomic<uint32_t> bus_recoveries;
+        std::atomic<uint32_t> latency_hist[I2C_LATENCY_BUCKETS];
+        uint8_t               addr;
+    };
+
+    struct QueuedTransaction {
+        I2CTransaction t;
+        int64_t        deadline_us;   // absolute esp_timer time, 0 = none
+        bool           stop;
+    };
+
+    friend class I2CRegCache;
+    friend class I2CBusLock;
+    friend class I2CGroup;
+
+    esp_err_t get_device(uint8_t dev_addr);
     esp_err_t recover_bus();
+    esp_err_t restore_device(uint8_t addr);
+    esp_err_t raw_write(uint8_t addr, const uint8_t *data, size_t len);
+    void      teardown_driver();
+    esp_err_t rebuild_driver();
+    bool      soft_recover(uint8_t addr);
+    esp_err_t recover_ladder(uint8_t addr);
+    bool      bus_answers(uint8_t addr);
+    void      record_tier(I2CRecoveryTier tier, uint8_t addr, int64_t t0, bool ok);
+
+    void      record_attempt(DeviceSlot &slot, uint32_t us, size_t bytes, bool ok);
+    void      record_bus_reset();
+    void      assign_metrics(uint8_t addr);
+    static void read_counters(const DeviceCounters &c, I2CDeviceMetrics *out);
+    void      note_presence(uint8_t addr, esp_err_t err);
+    uint32_t  device_hz(const DeviceSlot &slot) const;
+    void      adapt_speed(uint8_t addr, esp_err_t err);
+    void      set_speed(uint8_t addr, uint8_t speed);
+    esp_err_t attach_reg_cache(uint8_t dev_addr, I2CRegCache *cache);
+    void      detach_reg_cache(uint8_t dev_addr, I2CRegCache *cache);
+
+    template <typename Policy, typename Op>
+    esp_err_t run_retry(uint8_t addr, int64_t deadline_us, size_t nbytes, Op op);
+    esp_err_t retry_pause(uint32_t ms, int64_t deadline_us);
+    void      trace_retry(uint8_t addr, esp_err_t err, int attempt);
+    static int remaining_ms(int64_t deadline_us);
+
+    esp_err_t do_write(uint8_t addr, const uint8_t *data, size_t len, int64_t deadline_us);
+    esp_err_t do_read(uint8_t addr, uint8_t *data, size_t len, int64_t deadline_us);
+    esp_err_t do_write_then_read(uint8_t addr, const uint8_t *wdata, size_t wlen,
+                                 uint8_t *rdata, size_t rlen, int64_t deadline_us);
+    esp_err_t execute(const I2CTransaction &t, int64_t deadline_us);
+    esp_err_t do_batch(I2CRegOp *ops, size_t first, size_t end, bool merge);
+    esp_err_t run_batch(I2CRegOp *ops, size_t count, bool merge, size_t *next, int timeout_ms);
+    static void worker_task(void *arg);
+    static void finish(const I2CTransaction &t, esp_err_t err);
+
+    void      trip_breaker(uint8_t addr, esp_err_t err);
+    esp_err_t close_breaker(uint8_t addr);
+    int64_t   probe_quarantined();
+    static void probe_task(void *arg);
+
+    I2CBus(I2CBackend *backend, i2c_port_t port, uint32_t freq, bool owns_backend);
 
     i2c_port_t      m_port;
-    gpio_num_t      m_sda;
-    gpio_num_t      m_scl;
     uint32_t        m_freq;
+    esp_err_t       m_status;
+
+    I2CBackend               *m_backend;     // m_trace while a trace is attached
+    bool                      m_owns_backend;
+    I2CTrace                 *m_trace;
+    I2CArbiter                m_arbiter;
+    uint32_t                  m_lock_timeout_ms;
+    bool                      m_adaptive;
+    uint8_t                   m_top_speed;   // fastest ladder step allowed
+    DeviceSlot                m_slots[I2C_ADDR_SLOTS];
+
+    // Bus totals are 64 bit: the single writer (the task running the bus)
+    // brackets updates with m_stats_seq, readers retry on a torn copy.
+    I2CBusStats               m_stats;
+    int64_t                   m_stats_start_us;
+    std::atomic<uint32_t>     m_stats_seq;
+    DeviceCounters            m_dev_metrics[I2C_METRICS_MAX_DEVICES];
+    std::atomic<uint8_t>      m_dev_metrics_used;
+    I2CRecoveryStats          m_recovery;
+
+    // Presence cache: m_seen marks addresses whose m_present bit is meaningful
+    I2CAddrMap                m_present;
+    I2CAddrMap                m_seen;
+    uint32_t                  m_scan_tmo_ms;
+
+    QueueHandle_t       m_queue;
+    TaskHandle_t        m_worker;
+    SemaphoreHandle_t   m_worker_exit;
+    std::atomic<bool>   m_worker_stopping;   // stop_worker() running: submit() refuses
+    std::atomic<uint32_t> m_submitting;      // submit() calls past their check, not yet queued
 
-    i2c_master_bus_handle_t   m_bus_handle;
-    std::map<uint8_t, i2c_master_dev_handle_t> m_devices;
-    std::map<uint8_t, std::function<esp_err_t(void)>> m_recovery_callbacks;
-    std::map<uint8_t, int> m_failure_count;   // per‑device consecutive failures
+    TaskHandle_t        m_probe_task;     // created on the first breaker trip
+    SemaphoreHandle_t   m_probe_exit;
+    volatile bool       m_probe_stop;
 };
 
+/**
+ * @brief Holds an I2CBus across several calls, e.g. a read-modify-write.
+ * Calls made by the holder nest inside it; other tasks wait in priority
+ * order. Check status() before touching the bus.
+ */
+class I2CBusLock {
+public:
+    explicit I2CBusLock(I2CBus &bus, UBaseType_t priority = I2C_PRIO_OF_TASK);
+    ~I2CBusLock();
+    I2CBusLock(const I2CBusLock &) = delete;
+    I2CBusLock &operator=(const I2CBusLock &) = delete;
+
+    esp_err_t status() const { return m_status; }
+
+private:
+    I2CBus   &m_bus;
+    esp_err_t m_status;
+};
+
+/**
+ * @brief One device of a bus with its retry policy fixed at compile time.
+ * Costs the same as calling the bus with the policy spelled out.
+ */
+template <typename Policy = I2CRetryDefault>
+class I2CDevice {
+public:
+    I2CDevice(I2CBus &bus, uint8_t dev_addr) : m_bus(bus), m_addr(dev_addr) {}
+
+    esp_err_t write(const uint8_t *data, size_t len) {
+        return m_bus.write<Policy>(m_addr, data, len);
+    }
+    esp_err_t read(uint8_t *data, size_t len) {
+        return m_bus.read<Policy>(m_addr, data, len);
+    }
+    esp_err_t write_then_read(const uint8_t *write_data, size_t write_len, uint8_t *read_data, size_t read_len) {
+        return m_bus.write_then_read<Policy>(m_addr, write_data, write_len, read_data, read_len);
+    }
+
+    I2CBus  &bus() const { return m_bus; }
+    uint8_t  address() const { return m_addr; }
+
+private:
+    I2CBus &m_bus;
+    uint8_t m_addr;
+};
+
+// ---------------------------------------------------------------------
+// Retry engine, instantiated once per policy. `op(timeout_ms)` runs one
+// attempt on the backend; `nbytes` is the payload accounted in the bus
+// stats on success. Attempts run back-to-back under one bus lock unless
+// the policy pauses between them. When attempts run out the device is
+// quarantined (see ED_i2c_breaker.cpp) if the policy says so.
+// ---------------------------------------------------------------------
+inline int I2CBus::remaining_ms(int64_t deadline_us) {
+    if (deadline_us == 0) return -1;   // no deadline: the driver waits forever
+    int64_t left = deadline_us - esp_timer_get_time();
+    if (left <= 0) return 0;
+    return (int)((left + 999) / 1000);
+}
+
+template <typename Policy, typename Op>
+esp_err_t I2CBus::run_retry(uint8_t addr, int64_t deadline_us, size_t nbytes, Op op) {
+    if (addr >= I2C_ADDR_SLOTS) return ESP_ERR_INVALID_ARG;
+    if (m_status != ESP_OK) return m_status;
+    I2CBusLock lock(*this);
+    if (lock.status() != ESP_OK) return lock.status();
+    DeviceSlot &slot = m_slots[addr];
+
+    for (int attempt = 1;; attempt++) {
+        if (slot.breaker != I2CBreakerState::CLOSED) return ESP_ERR_I2C_QUARANTINED;
+        int tmo = remaining_ms(deadline_us);
+        if (tmo == 0) return ESP_ERR_TIMEOUT;
+
+        uint32_t us = 0;
+        esp_err_t err = get_device(addr);
+        if (err == ESP_OK) {
+            int64_t t0 = esp_timer_get_time();
+            err = op(tmo);
+            us = (uint32_t)(esp_timer_get_time() - t0);
+            note_presence(addr, err);
+            if (m_adaptive) adapt_speed(addr, err);
+        }
+        record_attempt(slot, us, nbytes, err == ESP_OK);
+        // A call made while the device is being restored (its recovery
+        // callback) leaves the failure count alone: only a transaction of
+        // the caller proves the device healthy, and the restore in progress
+        // reports a failure
+        if (slot.recovering) return err;
+        if (err == ESP_OK) {
+            slot.failures = 0;
+            slot.backoff_ms = 0;
+            return ESP_OK;
+        }
+
+        slot.failures++;
+        bool last = Policy::max_attempts > 0 && attempt >= Policy::max_attempts;
+        if (last) {
+            if constexpr (Policy::quarantine) trip_breaker(addr, err);
+            return err;
+        }
+        if (m_trace) trace_retry(addr, err, attempt);
+
+        // Recovery only runs when another attempt follows. Soft recovery
+        // first; the ladder when the device has nothing to restore or its
+        // restore fails, after `soft_limit` consecutive failures, and in any
+        // case before the call's last attempt
+        if constexpr (Policy::recovery == I2CRetryRecovery::SOFT_THEN_BUS) {
+            bool ladder = slot.failures > Policy::soft_limit ||
+                          (Policy::max_attempts > 0 && attempt + 1 >= Policy::max_attempts);
+            if (ladder || !soft_recover(addr)) {
+                recover_ladder(addr);
+                slot.failures = 0;
+            }
+        } else if constexpr (Policy::recovery == I2CRetryRecovery::BUS) {
+            recover_ladder(addr);
+            slot.failures = 0;
+        }
+
+        uint32_t pause_ms = Policy::backoff_ms(attempt);
+        if (pause_ms) {
+            esp_err_t perr = retry_pause(pause_ms, deadline_us);
+            if (perr != ESP_OK) return perr;
+        }
+    }
+}
+
+template <typename Policy>
+esp_err_t I2CBus::write(uint8_t addr, const uint8_t *data, size_t len) {
+    return run_retry<Policy>(addr, 0, len, [&](int tmo) {
+        return m_backend->transmit(addr, data, len, tmo);
+    });
+}
+
+template <typename Policy>
+esp_err_t I2CBus::read(uint8_t addr, uint8_t *data, size_t len) {
+    return run_retry<Policy>(addr, 0, len, [&](int tmo) {
+        return m_backend->receive(addr, data, len, tmo);
+    });
+}
+
+template <typename Policy>
+esp_err_t I2CBus::write_then_read(uint8_t addr, const uint8_t *wdata, size_t wlen, uint8_t *rdata, size_t rlen) {
+    return run_retry<Policy>(addr, 0, wlen + rlen, [&](int tmo) {
+        return m_backend->transmit_receive(addr, wdata, wlen, rdata, rlen, tmo);
+    });
+}
+
 #endif // ED_I2C_H
\ No newline at end of file
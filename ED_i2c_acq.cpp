@@ -0,0 +1,211 @@
+#include "ED_i2c_acq.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <cstring>
+
+static const char *TAG = "ed_i2c_acq";
+
+#define I2C_ACQ_TASK_STACK_SIZE   3072
+
+I2CAcquisition::I2CAcquisition(I2CBus &bus)
+    : m_bus(bus), m_channels(), m_count(0), m_mux(),
+      m_task(nullptr), m_task_exit(nullptr)
+{
+    portMUX_INITIALIZE(&m_mux);
+}
+
+I2CAcquisition::~I2CAcquisition() {
+    stop();
+#if !CONFIG_IDF_TARGET_LINUX
+    for (int i = 0; i < m_count; i++) {
+        if (m_channels[i].pin >= 0) gpio_isr_handler_remove((gpio_num_t)m_channels[i].pin);
+    }
+#endif
+}
+
+// ---------------------------------------------------------------------
+// Channels
+// ---------------------------------------------------------------------
+esp_err_t I2CAcquisition::new_channel(const I2CReadDesc &desc, int pin, int *channel) {
+    if (desc.addr >= I2C_ADDR_SLOTS || desc.len == 0 || desc.len > I2C_ACQ_MAX_READ || desc.reg > 0xFF)
+        return ESP_ERR_INVALID_ARG;
+    if (m_task) return ESP_ERR_INVALID_STATE;   // channels are fixed while running
+    if (m_count >= I2C_ACQ_MAX_CHANNELS) return ESP_ERR_NO_MEM;
+
+    Channel &ch = m_channels[m_count];
+    ch.desc = desc;
+    ch.pin = pin;
+    ch.owner = this;
+    ch.index = (uint8_t)m_count;
+    if (channel) *channel = m_count;
+    m_count++;
+    return ESP_OK;
+}
+
+esp_err_t I2CAcquisition::add_channel(const I2CReadDesc &desc, int *channel) {
+    return new_channel(desc, -1, channel);
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+esp_err_t I2CAcquisition::bind(gpio_num_t pin, gpio_int_type_t edge, const I2CReadDesc &desc, int *channel) {
+    int idx;
+    esp_err_t err = new_channel(desc, pin, &idx);
+    if (err != ESP_OK) return err;
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = 1ULL << pin,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = edge,
+    };
+    err = gpio_config(&io_conf);
+    if (err == ESP_OK) {
+        err = gpio_install_isr_service(0);
+        if (err == ESP_ERR_INVALID_STATE) err = ESP_OK;   // already installed by someone else
+    }
+    if (err == ESP_OK) err = gpio_isr_handler_add(pin, gpio_isr, &m_channels[idx]);
+    if (err == ESP_OK) gpio_intr_disable(pin);   // enabled by start()
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO%d: cannot attach data-ready interrupt (%s)", (int)pin, esp_err_to_name(err));
+        m_count--;
+        return err;
+    }
+    if (channel) *channel = idx;
+    return ESP_OK;
+}
+#endif
+
+// ---------------------------------------------------------------------
+// Interrupt side: timestamp and wake the task, nothing else
+// ---------------------------------------------------------------------
+void IRAM_ATTR I2CAcquisition::trigger_from_isr(int channel) {
+    if (channel < 0 || channel >= m_count || !m_task) return;
+    Channel &ch = m_channels[channel];
+    portENTER_CRITICAL_ISR(&m_mux);
+    ch.pending_ts = esp_timer_get_time();
+    ch.irqs++;
+    portEXIT_CRITICAL_ISR(&m_mux);
+
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(m_task, 1u << channel, eSetBits, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void IRAM_ATTR I2CAcquisition::gpio_isr(void *arg) {
+    Channel *ch = static_cast<Channel *>(arg);
+    ch->owner->trigger_from_isr(ch->index);
+}
+
+void I2CAcquisition::trigger(int channel) {
+    if (channel < 0 || channel >= m_count || !m_task) return;
+    Channel &ch = m_channels[channel];
+    portENTER_CRITICAL(&m_mux);
+    ch.pending_ts = esp_timer_get_time();
+    ch.irqs++;
+    portEXIT_CRITICAL(&m_mux);
+    xTaskNotify(m_task, 1u << channel, eSetBits);
+}
+
+// ---------------------------------------------------------------------
+// Acquisition task
+// ---------------------------------------------------------------------
+void I2CAcquisition::acquire(Channel &ch) {
+    I2CSample s;
+    portENTER_CRITICAL(&m_mux);
+    s.timestamp_us = ch.pending_ts;
+    s.seq = ch.irqs;
+    portEXIT_CRITICAL(&m_mux);
+    if (s.seq - ch.last_irqs > 1) ch.stats.coalesced += s.seq - ch.last_irqs - 1;
+    ch.last_irqs = s.seq;
+
+    s.len = ch.desc.len;
+    if (ch.desc.reg < 0) {
+        s.status = m_bus.read(ch.desc.addr, s.data, s.len);
+    } else {
+        uint8_t reg = (uint8_t)ch.desc.reg;
+        s.status = m_bus.write_then_read(ch.desc.addr, &reg, 1, s.data, s.len);
+    }
+    if (s.status != ESP_OK) ch.stats.read_errors++;
+
+    if (!ch.ring.push(s)) {
+        ch.stats.overflows++;
+        return;
+    }
+    ch.stats.samples++;
+    if (ch.consumer) xTaskNotifyGive(ch.consumer);
+}
+
+void I2CAcquisition::task(void *arg) {
+    I2CAcquisition *acq = static_cast<I2CAcquisition *>(arg);
+    while (1) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+        if (bits & STOP_BIT) break;
+        for (int i = 0; i < acq->m_count; i++) {
+            if (bits & (1u << i)) acq->acquire(acq->m_channels[i]);
+        }
+    }
+    xSemaphoreGive(acq->m_task_exit);
+    vTaskDelete(nullptr);
+}
+
+esp_err_t I2CAcquisition::start(UBaseType_t priority, BaseType_t core) {
+    if (m_task) return ESP_ERR_INVALID_STATE;
+    m_task_exit = xSemaphoreCreateBinary();
+    if (!m_task_exit) return ESP_ERR_NO_MEM;
+    if (xTaskCreatePinnedToCore(task, "i2c_acq", I2C_ACQ_TASK_STACK_SIZE, this, priority,
+                                &m_task, core) != pdPASS) {
+        vSemaphoreDelete(m_task_exit);
+        m_task_exit = nullptr;
+        m_task = nullptr;
+        return ESP_ERR_NO_MEM;
+    }
+#if !CONFIG_IDF_TARGET_LINUX
+    for (int i = 0; i < m_count; i++) {
+        if (m_channels[i].pin >= 0) gpio_intr_enable((gpio_num_t)m_channels[i].pin);
+    }
+#endif
+    return ESP_OK;
+}
+
+void I2CAcquisition::stop() {
+    if (!m_task) return;
+#if !CONFIG_IDF_TARGET_LINUX
+    for (int i = 0; i < m_count; i++) {
+        if (m_channels[i].pin >= 0) gpio_intr_disable((gpio_num_t)m_channels[i].pin);
+    }
+#endif
+    xTaskNotify(m_task, STOP_BIT, eSetBits);
+    xSemaphoreTake(m_task_exit, portMAX_DELAY);
+    vSemaphoreDelete(m_task_exit);
+    m_task_exit = nullptr;
+    m_task = nullptr;
+}
+
+// ---------------------------------------------------------------------
+// Consumer side
+// ---------------------------------------------------------------------
+bool I2CAcquisition::pop(int channel, I2CSample *out) {
+    if (channel < 0 || channel >= m_count || !out) return false;
+    return m_channels[channel].ring.pop(out);
+}
+
+size_t I2CAcquisition::available(int channel) const {
+    if (channel < 0 || channel >= m_count) return 0;
+    return m_channels[channel].ring.size();
+}
+
+void I2CAcquisition::set_consumer(int channel, TaskHandle_t task) {
+    if (channel >= 0 && channel < m_count) m_channels[channel].consumer = task;
+}
+
+esp_err_t I2CAcquisition::get_stats(int channel, I2CAcqStats *out) const {
+    if (channel < 0 || channel >= m_count || !out) return ESP_ERR_INVALID_ARG;
+    const Channel &ch = m_channels[channel];
+    *out = ch.stats;
+    portENTER_CRITICAL(&m_mux);
+    out->irqs = ch.irqs;
+    portEXIT_CRITICAL(&m_mux);
+    return ESP_OK;
+}
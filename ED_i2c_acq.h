@@ -0,0 +1,135 @@
+#ifndef ED_I2C_ACQ_H
+#define ED_I2C_ACQ_H
+
+#include "ED_i2c.h"
+#include "esp_attr.h"
+#include <atomic>
+
+#define I2C_ACQ_MAX_CHANNELS   8
+#define I2C_ACQ_RING_LEN       16    // samples per channel, power of two
+#define I2C_ACQ_MAX_READ       16    // bytes per sample
+
+static_assert((I2C_ACQ_RING_LEN & (I2C_ACQ_RING_LEN - 1)) == 0, "I2C_ACQ_RING_LEN must be a power of two");
+
+// What to read when a channel fires
+struct I2CReadDesc {
+    uint8_t addr;
+    int16_t reg;    // register pointer written first, -1 = plain read
+    uint8_t len;    // up to I2C_ACQ_MAX_READ
+};
+
+struct I2CSample {
+    int64_t   timestamp_us;   // esp_timer time of the data-ready interrupt
+    uint32_t  seq;            // interrupt count of the channel; a gap = interrupts merged into one read
+    esp_err_t status;
+    uint8_t   len;
+    uint8_t   data[I2C_ACQ_MAX_READ];
+};
+
+struct I2CAcqStats {
+    uint32_t irqs;
+    uint32_t samples;       // pushed into the ring
+    uint32_t coalesced;     // interrupts that arrived before the previous read was done
+    uint32_t overflows;     // samples dropped on a full ring
+    uint32_t read_errors;
+};
+
+/**
+ * @brief Single-producer single-consumer sample ring, lock-free.
+ * The acquisition task pushes, one consumer task pops.
+ */
+class I2CSampleRing {
+public:
+    bool   push(const I2CSample &s) {
+        uint32_t h = m_head.load(std::memory_order_relaxed);
+        if (h - m_tail.load(std::memory_order_acquire) == I2C_ACQ_RING_LEN) return false;
+        m_buf[h & (I2C_ACQ_RING_LEN - 1)] = s;
+        m_head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    bool   pop(I2CSample *out) {
+        uint32_t t = m_tail.load(std::memory_order_relaxed);
+        if (m_head.load(std::memory_order_acquire) == t) return false;
+        *out = m_buf[t & (I2C_ACQ_RING_LEN - 1)];
+        m_tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    size_t size() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    I2CSample             m_buf[I2C_ACQ_RING_LEN];
+    std::atomic<uint32_t> m_head{0};
+    std::atomic<uint32_t> m_tail{0};
+};
+
+/**
+ * @brief Interrupt-driven acquisition on one I2CBus.
+ *
+ * Each channel binds a data-ready pin to a read descriptor. The ISR only
+ * timestamps the edge and wakes the acquisition task, which performs the
+ * read and pushes a timestamped sample into the channel's ring. Reads
+ * happen when data is ready, never on a stale register and without a
+ * polling period of latency.
+ *
+ * Interrupts that arrive while a channel's read is still pending collapse
+ * into one read (counted in `coalesced`), so a slow bus degrades to the
+ * newest data rather than a backlog.
+ */
+class I2CAcquisition {
+public:
+    explicit I2CAcquisition(I2CBus &bus);
+    ~I2CAcquisition();
+    I2CAcquisition(const I2CAcquisition &) = delete;
+    I2CAcquisition &operator=(const I2CAcquisition &) = delete;
+
+#if !CONFIG_IDF_TARGET_LINUX
+    // GPIO data-ready channel. Installs the shared GPIO ISR service if needed.
+    esp_err_t bind(gpio_num_t pin, gpio_int_type_t edge, const I2CReadDesc &desc, int *channel);
+#endif
+    // Channel fired by trigger()/trigger_from_isr() only (timer ISR, simulation)
+    esp_err_t add_channel(const I2CReadDesc &desc, int *channel);
+
+    esp_err_t start(UBaseType_t priority = 12, BaseType_t core = tskNO_AFFINITY);
+    void      stop();
+
+    void IRAM_ATTR trigger_from_isr(int channel);
+    void      trigger(int channel);
+
+    // Consumer side
+    bool      pop(int channel, I2CSample *out);
+    size_t    available(int channel) const;
+    void      set_consumer(int channel, TaskHandle_t task);   // xTaskNotifyGive() after each sample
+    esp_err_t get_stats(int channel, I2CAcqStats *out) const;
+
+private:
+    struct Channel {
+        I2CReadDesc   desc;
+        int           pin;            // -1 = software channel
+        int64_t       pending_ts;     // written by the ISR under m_mux
+        uint32_t      irqs;           // written by the ISR under m_mux
+        uint32_t      last_irqs;
+        TaskHandle_t  consumer;
+        I2CAcqStats   stats;
+        I2CSampleRing ring;
+        I2CAcquisition *owner;
+        uint8_t       index;
+    };
+
+    static constexpr uint32_t STOP_BIT = 1u << 31;
+
+    esp_err_t   new_channel(const I2CReadDesc &desc, int pin, int *channel);
+    void        acquire(Channel &ch);
+    static void IRAM_ATTR gpio_isr(void *arg);
+    static void task(void *arg);
+
+    I2CBus            &m_bus;
+    Channel            m_channels[I2C_ACQ_MAX_CHANNELS];
+    int                m_count;
+    mutable portMUX_TYPE m_mux;
+    TaskHandle_t       m_task;
+    SemaphoreHandle_t  m_task_exit;
+};
+
+#endif // ED_I2C_ACQ_H
@@ -0,0 +1,194 @@
+#include "ED_i2c.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "ed_i2c";
+
+#define I2C_WORKER_STACK_SIZE   4096
+
+// ---------------------------------------------------------------------
+// I2CFuture
+// ---------------------------------------------------------------------
+I2CFuture::I2CFuture() : m_result(ESP_ERR_INVALID_STATE), m_done(false) {
+    m_sem = xSemaphoreCreateBinaryStatic(&m_sem_buf);
+}
+
+I2CFuture::~I2CFuture() {
+    vSemaphoreDelete(m_sem);
+}
+
+void I2CFuture::reset() {
+    xSemaphoreTake(m_sem, 0);   // drop a stale completion, if any
+    m_result = ESP_ERR_INVALID_STATE;
+    m_done = false;
+}
+
+void I2CFuture::complete(esp_err_t err) {
+    m_result = err;
+    m_done = true;
+    xSemaphoreGive(m_sem);
+}
+
+esp_err_t I2CFuture::wait(TickType_t ticks) {
+    if (m_done) return m_result;
+    if (xSemaphoreTake(m_sem, ticks) != pdTRUE) return ESP_ERR_TIMEOUT;
+    return m_result;
+}
+
+// ---------------------------------------------------------------------
+// Worker lifecycle
+// ---------------------------------------------------------------------
+void I2CBus::finish(const I2CTransaction &t, esp_err_t err) {
+    if (t.cb) t.cb(err, t.cb_arg);
+    if (t.future) t.future->complete(err);
+}
+
+esp_err_t I2CBus::start_worker(size_t queue_len, UBaseType_t priority, BaseType_t core) {
+    if (m_worker) return ESP_ERR_INVALID_STATE;
+    if (queue_len == 0) return ESP_ERR_INVALID_ARG;
+
+    m_queue = xQueueCreate(queue_len, sizeof(QueuedTransaction));
+    m_worker_exit = xSemaphoreCreateBinary();
+    if (!m_queue || !m_worker_exit) {
+        if (m_queue) vQueueDelete(m_queue);
+        if (m_worker_exit) vSemaphoreDelete(m_worker_exit);
+        m_queue = nullptr;
+        m_worker_exit = nullptr;
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreatePinnedToCore(worker_task, "i2c_worker", I2C_WORKER_STACK_SIZE,
+                                this, priority, &m_worker, core) != pdPASS) {
+        vQueueDelete(m_queue);
+        vSemaphoreDelete(m_worker_exit);
+        m_queue = nullptr;
+        m_worker_exit = nullptr;
+        m_worker = nullptr;
+        return ESP_ERR_NO_MEM;
+    }
+    m_worker_stopping = false;
+    ESP_LOGI(TAG, "Worker started on port %d (queue=%u)", (int)m_port, (unsigned)queue_len);
+    return ESP_OK;
+}
+
+void I2CBus::stop_worker() {
+    if (!m_worker) return;
+    // The stop marker is queued behind pending work, so everything already
+    // submitted still completes before the worker exits.
+    m_worker_stopping = true;
+    QueuedTransaction q = {};
+    q.stop = true;
+    xQueueSendToBack(m_queue, &q, portMAX_DELAY);
+    xSemaphoreTake(m_worker_exit, portMAX_DELAY);
+
+    // A submit() that passed its check before the stop may still enqueue
+    // behind the marker: fail what it queued, and free the queue only once
+    // no submit() is left inside
+    for (;;) {
+        bool idle = m_submitting.load() == 0;
+        while (xQueueReceive(m_queue, &q, 0) == pdTRUE) {
+            if (!q.stop) finish(q.t, ESP_ERR_INVALID_STATE);
+        }
+        if (idle) break;
+        vTaskDelay(1);
+    }
+
+    vQueueDelete(m_queue);
+    vSemaphoreDelete(m_worker_exit);
+    m_queue = nullptr;
+    m_worker_exit = nullptr;
+    m_worker = nullptr;
+}
+
+void I2CBus::worker_task(void *arg) {
+    I2CBus *bus = static_cast<I2CBus *>(arg);
+    QueuedTransaction q;
+    while (true) {
+        xQueueReceive(bus->m_queue, &q, portMAX_DELAY);
+        if (q.stop) break;
+
+        esp_err_t err;
+        if (q.deadline_us != 0 && esp_timer_get_time() >= q.deadline_us) {
+            err = ESP_ERR_TIMEOUT;   // expired while queued, never touches the bus
+        } else {
+            err = bus->execute(q.t, q.deadline_us);
+        }
+        finish(q.t, err);
+    }
+    xSemaphoreGive(bus->m_worker_exit);
+    vTaskDelete(nullptr);
+}
+
+esp_err_t I2CBus::execute(const I2CTransaction &t, int64_t deadline_us) {
+    switch (t.op) {
+    case I2CTransaction::Op::WRITE:
+        return do_write(t.addr, t.wdata, t.wlen, deadline_us);
+    case I2CTransaction::Op::READ:
+        return do_read(t.addr, t.rdata, t.rlen, deadline_us);
+    case I2CTransaction::Op::WRITE_READ:
+        return do_write_then_read(t.addr, t.wdata, t.wlen, t.rdata, t.rlen, deadline_us);
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+// ---------------------------------------------------------------------
+// Submission
+// ---------------------------------------------------------------------
+esp_err_t I2CBus::submit(const I2CTransaction &t, TickType_t enqueue_wait) {
+    // Counted in before the check: stop_worker() either sees this call and
+    // waits for it, or this call sees the stop and refuses
+    m_submitting.fetch_add(1);
+    if (!m_worker || m_worker_stopping) {
+        m_submitting.fetch_sub(1);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    QueuedTransaction q = {};
+    q.t = t;
+    q.deadline_us = t.timeout_ms ? esp_timer_get_time() + (int64_t)t.timeout_ms * 1000 : 0;
+    q.stop = false;
+    if (t.future) t.future->reset();
+
+    // Bounded queue: a full queue is reported, never grown
+    BaseType_t sent = xQueueSendToBack(m_queue, &q, enqueue_wait);
+    m_submitting.fetch_sub(1);
+    return sent == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t I2CBus::write_async(uint8_t addr, const uint8_t *data, size_t len,
+                              I2CFuture *future, uint32_t timeout_ms) {
+    I2CTransaction t;
+    t.op = I2CTransaction::Op::WRITE;
+    t.addr = addr;
+    t.wdata = data;
+    t.wlen = len;
+    t.timeout_ms = timeout_ms;
+    t.future = future;
+    return submit(t);
+}
+
+esp_err_t I2CBus::read_async(uint8_t addr, uint8_t *data, size_t len,
+                             I2CFuture *future, uint32_t timeout_ms) {
+    I2CTransaction t;
+    t.op = I2CTransaction::Op::READ;
+    t.addr = addr;
+    t.rdata = data;
+    t.rlen = len;
+    t.timeout_ms = timeout_ms;
+    t.future = future;
+    return submit(t);
+}
+
+esp_err_t I2CBus::write_then_read_async(uint8_t addr, const uint8_t *wdata, size_t wlen,
+                                        uint8_t *rdata, size_t rlen,
+                                        I2CFuture *future, uint32_t timeout_ms) {
+    I2CTransaction t;
+    t.op = I2CTransaction::Op::WRITE_READ;
+    t.addr = addr;
+    t.wdata = wdata;
+    t.wlen = wlen;
+    t.rdata = rdata;
+    t.rlen = rlen;
+    t.timeout_ms = timeout_ms;
+    t.future = future;
+    return submit(t);
+}
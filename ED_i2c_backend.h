@@ -0,0 +1,47 @@
+#ifndef ED_I2C_BACKEND_H
+#define ED_I2C_BACKEND_H
+
+#include "esp_err.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Transport under I2CBus.
+ *
+ * I2CBus keeps retries, the recovery ladder, quarantine and metrics; a
+ * backend only moves bytes and performs the physical recovery steps the
+ * ladder asks for. Devices are addressed by their 7-bit address, so any
+ * per-device handle stays inside the backend.
+ *
+ * Error codes follow the IDF i2c_master driver: a NACK during a transfer
+ * is ESP_ERR_INVALID_STATE, a NACK to a probe is ESP_ERR_NOT_FOUND, a
+ * stuck or silent bus is ESP_ERR_TIMEOUT. `timeout_ms` = -1 waits forever.
+ */
+class I2CBackend {
+public:
+    virtual ~I2CBackend() = default;
+
+    // Controller lifetime. close() also drops every device.
+    virtual esp_err_t open() = 0;
+    virtual void      close() = 0;
+    virtual bool      is_open() const = 0;
+
+    virtual esp_err_t add_device(uint8_t addr, uint32_t scl_hz) = 0;
+    virtual void      remove_device(uint8_t addr) = 0;
+
+    virtual esp_err_t transmit(uint8_t addr, const uint8_t *data, size_t len, int timeout_ms) = 0;
+    // Register write: `reg`, then `len` bytes of `data`, in one transfer, without a staging copy
+    virtual esp_err_t transmit_reg(uint8_t addr, uint8_t reg, const uint8_t *data, size_t len,
+                                   int timeout_ms) = 0;
+    virtual esp_err_t receive(uint8_t addr, uint8_t *data, size_t len, int timeout_ms) = 0;
+    virtual esp_err_t transmit_receive(uint8_t addr, const uint8_t *wdata, size_t wlen,
+                                       uint8_t *rdata, size_t rlen, int timeout_ms) = 0;
+    virtual esp_err_t probe(uint8_t addr, int timeout_ms) = 0;
+
+    // Recovery primitives, cheapest first
+    virtual esp_err_t bus_reset() = 0;      // controller-driven 9 clocks + STOP, controller open
+    virtual void      bus_clear() = 0;      // bit-banged 9 clocks + STOP, controller closed
+    virtual void      periph_reset() = 0;   // hardware module reset, controller closed
+};
+
+#endif // ED_I2C_BACKEND_H
@@ -0,0 +1,145 @@
+#include "ED_i2c_backend_esp.h"
+#include "ED_i2c.h"
+#include "driver/periph_ctrl.h"
+#include "soc/periph_defs.h"
+#include "rom/ets_sys.h"
+
+I2CEspBackend::I2CEspBackend(i2c_port_t port, gpio_num_t sda, gpio_num_t scl)
+    : m_port(port), m_sda(sda), m_scl(scl), m_bus_handle(nullptr), m_dev() {}
+
+I2CEspBackend::~I2CEspBackend() {
+    close();
+}
+
+// ---------------------------------------------------------------------
+// Controller and devices
+// ---------------------------------------------------------------------
+esp_err_t I2CEspBackend::open() {
+    if (m_bus_handle) return ESP_OK;
+    i2c_master_bus_config_t bus_cfg = {
+        .i2c_port = m_port,
+        .sda_io_num = m_sda,
+        .scl_io_num = m_scl,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags = { .enable_internal_pullup = true, .allow_pd = false },
+    };
+    return i2c_new_master_bus(&bus_cfg, &m_bus_handle);
+}
+
+void I2CEspBackend::close() {
+    for (i2c_master_dev_handle_t &d : m_dev) {
+        if (d) i2c_master_bus_rm_device(d);
+        d = nullptr;
+    }
+    if (m_bus_handle) {
+        i2c_del_master_bus(m_bus_handle);
+        m_bus_handle = nullptr;
+    }
+}
+
+esp_err_t I2CEspBackend::add_device(uint8_t addr, uint32_t scl_hz) {
+    if (!m_bus_handle) return ESP_ERR_INVALID_STATE;
+    if (addr >= I2C_ADDR_SLOTS) return ESP_ERR_INVALID_ARG;
+    if (m_dev[addr]) return ESP_OK;
+    i2c_device_config_t dev_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = addr,
+        .scl_speed_hz = scl_hz,
+        .scl_wait_us = 0,
+        .flags = { .disable_ack_check = false },
+    };
+    return i2c_master_bus_add_device(m_bus_handle, &dev_cfg, &m_dev[addr]);
+}
+
+void I2CEspBackend::remove_device(uint8_t addr) {
+    if (addr >= I2C_ADDR_SLOTS || !m_dev[addr]) return;
+    i2c_master_bus_rm_device(m_dev[addr]);
+    m_dev[addr] = nullptr;
+}
+
+// ---------------------------------------------------------------------
+// Transfers
+// ---------------------------------------------------------------------
+esp_err_t I2CEspBackend::transmit(uint8_t addr, const uint8_t *data, size_t len, int timeout_ms) {
+    if (addr >= I2C_ADDR_SLOTS || !m_dev[addr]) return ESP_ERR_INVALID_STATE;
+    return i2c_master_transmit(m_dev[addr], data, len, timeout_ms);
+}
+
+esp_err_t I2CEspBackend::transmit_reg(uint8_t addr, uint8_t reg, const uint8_t *data, size_t len,
+                                      int timeout_ms) {
+    if (addr >= I2C_ADDR_SLOTS || !m_dev[addr]) return ESP_ERR_INVALID_STATE;
+    i2c_master_transmit_multi_buffer_info_t bufs[2] = {};
+    bufs[0].write_buffer = &reg;
+    bufs[0].buffer_size = 1;
+    bufs[1].write_buffer = const_cast<uint8_t *>(data);
+    bufs[1].buffer_size = len;
+    return i2c_master_multi_buffer_transmit(m_dev[addr], bufs, 2, timeout_ms);
+}
+
+esp_err_t I2CEspBackend::receive(uint8_t addr, uint8_t *data, size_t len, int timeout_ms) {
+    if (addr >= I2C_ADDR_SLOTS || !m_dev[addr]) return ESP_ERR_INVALID_STATE;
+    return i2c_master_receive(m_dev[addr], data, len, timeout_ms);
+}
+
+esp_err_t I2CEspBackend::transmit_receive(uint8_t addr, const uint8_t *wdata, size_t wlen,
+                                          uint8_t *rdata, size_t rlen, int timeout_ms) {
+    if (addr >= I2C_ADDR_SLOTS || !m_dev[addr]) return ESP_ERR_INVALID_STATE;
+    return i2c_master_transmit_receive(m_dev[addr], wdata, wlen, rdata, rlen, timeout_ms);
+}
+
+esp_err_t I2CEspBackend::probe(uint8_t addr, int timeout_ms) {
+    if (!m_bus_handle) return ESP_ERR_INVALID_STATE;
+    // i2c_master_probe returns ESP_OK if device ACKs within timeout
+    return i2c_master_probe(m_bus_handle, addr, timeout_ms);
+}
+
+// ---------------------------------------------------------------------
+// Recovery primitives
+// ---------------------------------------------------------------------
+esp_err_t I2CEspBackend::bus_reset() {
+    if (!m_bus_handle) return ESP_ERR_INVALID_STATE;
+    return i2c_master_bus_reset(m_bus_handle);
+}
+
+// 9‑clock bus clear + STOP condition
+void I2CEspBackend::bus_clear() {
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << m_sda) | (1ULL << m_scl),
+        .mode = GPIO_MODE_OUTPUT_OD,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    gpio_config(&io_conf);
+
+    gpio_set_level(m_sda, 1);
+    for (int i = 0; i < 9; i++) {
+        gpio_set_level(m_scl, 0);
+        esp_rom_delay_us(5);
+        gpio_set_level(m_scl, 1);
+        esp_rom_delay_us(5);
+    }
+    gpio_set_level(m_sda, 0);
+    esp_rom_delay_us(5);
+    gpio_set_level(m_scl, 1);
+    esp_rom_delay_us(5);
+    gpio_set_level(m_sda, 1);
+    esp_rom_delay_us(5);
+}
+
+// Hardware peripheral reset, on the module that backs this port.
+// LP I2C ports have no module to reset.
+void I2CEspBackend::periph_reset() {
+    periph_module_t module;
+    switch (m_port) {
+    case I2C_NUM_0: module = PERIPH_I2C0_MODULE; break;
+#if I2C_HP_PORT_COUNT > 1
+    case I2C_NUM_1: module = PERIPH_I2C1_MODULE; break;
+#endif
+    default: return;
+    }
+    periph_module_reset(module);
+    esp_rom_delay_us(100);
+    periph_module_enable(module);
+}
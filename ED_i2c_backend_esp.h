@@ -0,0 +1,47 @@
+#ifndef ED_I2C_BACKEND_ESP_H
+#define ED_I2C_BACKEND_ESP_H
+
+#include "ED_i2c_backend.h"
+#include "driver/i2c_master.h"
+#include "driver/gpio.h"
+
+/**
+ * @brief I2CBackend on the IDF i2c_master driver (one HP port).
+ *
+ * This is what I2CBus(port, sda, scl, freq) creates.
+ */
+class I2CEspBackend : public I2CBackend {
+public:
+    I2CEspBackend(i2c_port_t port, gpio_num_t sda, gpio_num_t scl);
+    ~I2CEspBackend() override;
+    I2CEspBackend(const I2CEspBackend &) = delete;
+    I2CEspBackend &operator=(const I2CEspBackend &) = delete;
+
+    esp_err_t open() override;
+    void      close() override;
+    bool      is_open() const override { return m_bus_handle != nullptr; }
+
+    esp_err_t add_device(uint8_t addr, uint32_t scl_hz) override;
+    void      remove_device(uint8_t addr) override;
+
+    esp_err_t transmit(uint8_t addr, const uint8_t *data, size_t len, int timeout_ms) override;
+    esp_err_t transmit_reg(uint8_t addr, uint8_t reg, const uint8_t *data, size_t len,
+                           int timeout_ms) override;
+    esp_err_t receive(uint8_t addr, uint8_t *data, size_t len, int timeout_ms) override;
+    esp_err_t transmit_receive(uint8_t addr, const uint8_t *wdata, size_t wlen,
+                               uint8_t *rdata, size_t rlen, int timeout_ms) override;
+    esp_err_t probe(uint8_t addr, int timeout_ms) override;
+
+    esp_err_t bus_reset() override;
+    void      bus_clear() override;
+    void      periph_reset() override;
+
+private:
+    i2c_port_t               m_port;
+    gpio_num_t               m_sda;
+    gpio_num_t               m_scl;
+    i2c_master_bus_handle_t  m_bus_handle;
+    i2c_master_dev_handle_t  m_dev[128];   // nullptr until add_device()
+};
+
+#endif // ED_I2C_BACKEND_ESP_H
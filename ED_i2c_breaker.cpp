@@ -0,0 +1,165 @@
+#include "ED_i2c.h"
+#include "ED_i2c_regcache.h"
+#include "ED_i2c_trace.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "ed_i2c";
+
+#define I2C_QUARANTINE_BASE_MS        200     // first probe after a trip
+#define I2C_QUARANTINE_MAX_MS         30000   // probe interval cap
+#define I2C_QUARANTINE_PROBE_TMO_MS   5
+#define I2C_PROBE_TASK_STACK_SIZE     3072
+#define I2C_PROBE_TASK_PRIORITY       2
+
+static const char *breaker_name(I2CBreakerState s) {
+    switch (s) {
+    case I2CBreakerState::CLOSED:    return "closed";
+    case I2CBreakerState::OPEN:      return "open";
+    case I2CBreakerState::HALF_OPEN: return "half-open";
+    }
+    return "?";
+}
+
+// ---------------------------------------------------------------------
+// State transitions
+// ---------------------------------------------------------------------
+void I2CBus::trip_breaker(uint8_t addr, esp_err_t err) {
+    DeviceSlot &s = m_slots[addr];
+    uint32_t backoff = s.backoff_ms ? s.backoff_ms * 2 : I2C_QUARANTINE_BASE_MS;
+    s.backoff_ms = backoff > I2C_QUARANTINE_MAX_MS ? I2C_QUARANTINE_MAX_MS : backoff;
+    s.open_until_us = esp_timer_get_time() + (int64_t)s.backoff_ms * 1000;
+    s.last_error = err;
+    s.trips++;
+    s.breaker = I2CBreakerState::OPEN;
+    if (m_trace) m_trace->event(I2CTraceOp::BREAKER_TRIP, addr, err, 0, 0);
+    ESP_LOGW(TAG, "0x%02X quarantined (%s), probing in %lu ms", addr, esp_err_to_name(err),
+             (unsigned long)s.backoff_ms);
+
+    if (!m_probe_task) {
+        m_probe_exit = xSemaphoreCreateBinary();
+        if (!m_probe_exit ||
+            xTaskCreate(probe_task, "i2c_probe", I2C_PROBE_TASK_STACK_SIZE, this,
+                        I2C_PROBE_TASK_PRIORITY, &m_probe_task) != pdPASS) {
+            ESP_LOGE(TAG, "cannot start probe task, 0x%02X stays quarantined", addr);
+            if (m_probe_exit) vSemaphoreDelete(m_probe_exit);
+            m_probe_exit = nullptr;
+            m_probe_task = nullptr;
+            return;
+        }
+    } else {
+        xTaskNotifyGive(m_probe_task);   // reschedule
+    }
+}
+
+// The device may have been power-cycled while away: it is back online only
+// once its configuration is restored. On failure the caller re-opens it.
+esp_err_t I2CBus::close_breaker(uint8_t addr) {
+    DeviceSlot &s = m_slots[addr];
+    s.breaker = I2CBreakerState::CLOSED;
+    s.open_until_us = 0;
+    esp_err_t err = restore_device(addr);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "0x%02X answers but was not restored (%s)", addr, esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGI(TAG, "0x%02X back online after %u trip(s)", addr, (unsigned)s.trips);
+    return ESP_OK;
+}
+
+void I2CBus::reset_breaker(uint8_t addr) {
+    if (addr >= I2C_ADDR_SLOTS) return;
+    I2CBusLock lock(*this);
+    if (lock.status() != ESP_OK) return;
+    DeviceSlot &s = m_slots[addr];
+    s.breaker = I2CBreakerState::CLOSED;
+    s.open_until_us = 0;
+    s.backoff_ms = 0;
+    s.failures = 0;
+}
+
+// ---------------------------------------------------------------------
+// Background probing
+// Probes every quarantined device whose backoff expired. A probe that times
+// out (rather than NACKs) means the bus itself is stuck: run the recovery
+// ladder once per pass. Probe and ladder run under the bus lock, so the
+// driver is never torn down under another task's transfer. Returns the
+// earliest next probe time, 0 if nothing is quarantined.
+// ---------------------------------------------------------------------
+int64_t I2CBus::probe_quarantined() {
+    int64_t next = 0;
+    bool bus_recovered = false;
+
+    for (uint8_t a = 0; a < I2C_ADDR_SLOTS; a++) {
+        DeviceSlot &s = m_slots[a];
+        if (s.breaker != I2CBreakerState::OPEN) continue;
+
+        if (esp_timer_get_time() >= s.open_until_us) {
+            I2CBusLock lock(*this);   // probes and recovery never interleave with a transfer
+            if (lock.status() != ESP_OK) {
+                if (next == 0 || s.open_until_us < next) next = s.open_until_us;
+                continue;
+            }
+            if (s.breaker != I2CBreakerState::OPEN) continue;   // reset_breaker() while we waited
+            s.breaker = I2CBreakerState::HALF_OPEN;
+            esp_err_t err = m_backend->probe(a, I2C_QUARANTINE_PROBE_TMO_MS);
+            if (err != ESP_OK && err != ESP_ERR_NOT_FOUND && !bus_recovered) {
+                ESP_LOGW(TAG, "probe of 0x%02X: %s, recovering bus", a, esp_err_to_name(err));
+                recover_ladder(a);
+                bus_recovered = true;
+                err = m_backend->probe(a, I2C_QUARANTINE_PROBE_TMO_MS);
+            }
+            note_presence(a, err);
+            if (err == ESP_OK && close_breaker(a) == ESP_OK) continue;
+            uint32_t backoff = s.backoff_ms * 2;
+            s.backoff_ms = backoff > I2C_QUARANTINE_MAX_MS ? I2C_QUARANTINE_MAX_MS : backoff;
+            s.open_until_us = esp_timer_get_time() + (int64_t)s.backoff_ms * 1000;
+            s.breaker = I2CBreakerState::OPEN;
+        }
+        if (next == 0 || s.open_until_us < next) next = s.open_until_us;
+    }
+    return next;
+}
+
+void I2CBus::probe_task(void *arg) {
+    I2CBus *bus = static_cast<I2CBus *>(arg);
+    while (!bus->m_probe_stop) {
+        int64_t next = bus->probe_quarantined();
+        TickType_t wait = portMAX_DELAY;
+        if (next != 0) {
+            int64_t left_ms = (next - esp_timer_get_time() + 999) / 1000;
+            wait = left_ms > 0 ? pdMS_TO_TICKS(left_ms) : 0;
+            if (wait == 0) wait = 1;
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+    xSemaphoreGive(bus->m_probe_exit);
+    vTaskDelete(nullptr);
+}
+
+// ---------------------------------------------------------------------
+// Inspection
+// ---------------------------------------------------------------------
+esp_err_t I2CBus::get_breaker(uint8_t addr, I2CBreakerInfo *out) const {
+    if (addr >= I2C_ADDR_SLOTS || !out) return ESP_ERR_INVALID_ARG;
+    const DeviceSlot &s = m_slots[addr];
+    out->state = s.breaker;
+    out->failures = s.failures;
+    out->trips = s.trips;
+    out->backoff_ms = s.backoff_ms;
+    out->last_error = s.last_error;
+    int64_t left = s.open_until_us - esp_timer_get_time();
+    out->retry_in_ms = (s.breaker != I2CBreakerState::CLOSED && left > 0) ? (uint32_t)(left / 1000) : 0;
+    return ESP_OK;
+}
+
+void I2CBus::log_breakers() const {
+    for (uint8_t a = 0; a < I2C_ADDR_SLOTS; a++) {
+        I2CBreakerInfo info;
+        get_breaker(a, &info);
+        if (info.state == I2CBreakerState::CLOSED && info.trips == 0) continue;
+        ESP_LOGI(TAG, "0x%02X: %s, trips=%u, backoff=%lu ms, next probe in %lu ms, last=%s",
+                 a, breaker_name(info.state), (unsigned)info.trips, (unsigned long)info.backoff_ms,
+                 (unsigned long)info.retry_in_ms, esp_err_to_name(info.last_error));
+    }
+}
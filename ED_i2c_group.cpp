@@ -0,0 +1,184 @@
+#include "ED_i2c_group.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <cstring>
+
+static const char *TAG = "ed_i2c_group";
+
+#define I2C_GROUP_TRIGGER_TMO_MS   10   // per trigger write: a slow member must not delay the rest
+
+I2CGroup::I2CGroup(I2CBus &bus, I2CTriggerMode mode, const uint8_t *gc_cmd, size_t gc_len)
+    : m_bus(bus), m_mode(mode), m_gc_cmd(), m_gc_len(0), m_members(), m_status(), m_count(0), m_last()
+{
+    if (gc_cmd && gc_len > 0 && gc_len <= I2C_GROUP_MAX_TRIGGER) {
+        memcpy(m_gc_cmd, gc_cmd, gc_len);
+        m_gc_len = (uint8_t)gc_len;
+    }
+    for (esp_err_t &s : m_status) s = ESP_ERR_NOT_FINISHED;
+}
+
+esp_err_t I2CGroup::add(const I2CGroupMember &member, int *index) {
+    if (member.addr == I2C_GENERAL_CALL_ADDR || member.addr >= I2C_ADDR_SLOTS || !member.data ||
+        member.len == 0 || member.len > I2C_GROUP_MAX_READ || member.trigger_len > I2C_GROUP_MAX_TRIGGER)
+        return ESP_ERR_INVALID_ARG;
+    if (m_mode == I2CTriggerMode::BACK_TO_BACK && member.trigger_len == 0) return ESP_ERR_INVALID_ARG;
+    if (m_count >= I2C_GROUP_MAX_MEMBERS) return ESP_ERR_NO_MEM;
+
+    m_members[m_count] = member;
+    m_status[m_count] = ESP_ERR_NOT_FINISHED;
+    if (index) *index = (int)m_count;
+    m_count++;
+    return ESP_OK;
+}
+
+esp_err_t I2CGroup::status(int index) const {
+    if (index < 0 || (size_t)index >= m_count) return ESP_ERR_INVALID_ARG;
+    return m_status[index];
+}
+
+// ---------------------------------------------------------------------
+// Trigger
+// ---------------------------------------------------------------------
+esp_err_t I2CGroup::trigger(I2CGroupSample *out) {
+    if (m_count == 0) return ESP_ERR_INVALID_STATE;
+    if (m_mode == I2CTriggerMode::GENERAL_CALL && m_gc_len == 0) return ESP_ERR_INVALID_STATE;
+
+    m_last = I2CGroupSample();
+    esp_err_t err = m_mode == I2CTriggerMode::GENERAL_CALL ? trigger_general_call(&m_last)
+                                                            : trigger_back_to_back(&m_last);
+    if (out) *out = m_last;
+    return err;
+}
+
+// One write, every member latches at the same STOP: the timestamp is the end
+// of the attempt that went through. The general-call address gets the
+// default retry like any other device; nobody ACKing it is ESP_ERR_NOT_FOUND.
+esp_err_t I2CGroup::trigger_general_call(I2CGroupSample *out) {
+    int64_t done_us = 0;
+    esp_err_t err = m_bus.run_retry<I2CRetryDefault>(I2C_GENERAL_CALL_ADDR, 0, m_gc_len, [&](int tmo) {
+        esp_err_t e = m_bus.m_backend->transmit(I2C_GENERAL_CALL_ADDR, m_gc_cmd, m_gc_len, tmo);
+        done_us = esp_timer_get_time();
+        return e;
+    });
+    for (size_t i = 0; i < m_count; i++) m_status[i] = err;
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "general call failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    out->ts_us = done_us;
+    out->triggered = (uint8_t)m_count;
+    return ESP_OK;
+}
+
+// The writes go out with nothing in between: handles are attached up front
+// and the per-attempt bookkeeping of I2CBus runs once they are all done.
+esp_err_t I2CGroup::trigger_back_to_back(I2CGroupSample *out) {
+    I2CBusLock lock(m_bus);
+    if (lock.status() != ESP_OK) return lock.status();
+
+    bool    go[I2C_GROUP_MAX_MEMBERS];
+    int64_t t0[I2C_GROUP_MAX_MEMBERS];
+    int64_t t1[I2C_GROUP_MAX_MEMBERS];
+    for (size_t i = 0; i < m_count; i++) {
+        const I2CGroupMember &m = m_members[i];
+        if (m_bus.m_slots[m.addr].breaker != I2CBreakerState::CLOSED) m_status[i] = ESP_ERR_I2C_QUARANTINED;
+        else m_status[i] = m_bus.get_device(m.addr);
+        go[i] = m_status[i] == ESP_OK;
+    }
+
+    for (size_t i = 0; i < m_count; i++) {
+        if (!go[i]) continue;
+        const I2CGroupMember &m = m_members[i];
+        t0[i] = esp_timer_get_time();
+        m_status[i] = m_bus.m_backend->transmit(m.addr, m.trigger, m.trigger_len, I2C_GROUP_TRIGGER_TMO_MS);
+        t1[i] = esp_timer_get_time();
+    }
+
+    // No retry and no recovery here, as with I2CNoRetry: a failure counts
+    // towards the recovery of the member's next ordinary call
+    int64_t sum = 0, first = 0, last = 0;
+    uint8_t n = 0;
+    for (size_t i = 0; i < m_count; i++) {
+        if (!go[i]) continue;
+        const I2CGroupMember &m = m_members[i];
+        I2CBus::DeviceSlot &slot = m_bus.m_slots[m.addr];
+        esp_err_t err = m_status[i];
+        m_bus.note_presence(m.addr, err);
+        if (m_bus.m_adaptive) m_bus.adapt_speed(m.addr, err);
+        m_bus.record_attempt(slot, (uint32_t)(t1[i] - t0[i]), m.trigger_len, err == ESP_OK);
+        if (err != ESP_OK) {
+            slot.failures++;
+            continue;
+        }
+        slot.failures = 0;
+        if (n == 0 || t1[i] < first) first = t1[i];
+        if (n == 0 || t1[i] > last) last = t1[i];
+        sum += t1[i];
+        n++;
+    }
+
+    if (n == 0) return ESP_FAIL;
+    out->ts_us = sum / n;
+    out->skew_us = (uint32_t)(last - first);
+    out->triggered = n;
+    return n == m_count ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+}
+
+// ---------------------------------------------------------------------
+// Collect
+// One batch over the members the trigger reached. Each member is its own
+// retry unit in transfer_batch(): one that fails does not stop the others.
+// ---------------------------------------------------------------------
+esp_err_t I2CGroup::collect(I2CGroupSample *out) {
+    I2CRegOp ops[I2C_GROUP_MAX_MEMBERS];
+    int      owner[I2C_GROUP_MAX_MEMBERS];
+    size_t   n = 0;
+    for (size_t i = 0; i < m_count; i++) {
+        if (m_status[i] != ESP_OK) continue;
+        const I2CGroupMember &m = m_members[i];
+        ops[n] = {I2CRegOp::Dir::READ, m.addr, m.reg, m.data, m.len, ESP_ERR_NOT_FINISHED};
+        owner[n++] = (int)i;
+    }
+    m_last.collected = 0;
+    if (n == 0) {
+        if (out) *out = m_last;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = m_bus.transfer_batch(ops, n, false);   // per-member status in ops
+
+    for (size_t k = 0; k < n; k++) {
+        m_status[owner[k]] = ops[k].status;
+        if (ops[k].status == ESP_OK) m_last.collected++;
+    }
+    if (out) *out = m_last;
+    if (m_last.collected == 0) return err;
+    return m_last.collected == m_count ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+}
+
+esp_err_t I2CGroup::sample(uint32_t settle_us, I2CGroupSample *out) {
+    esp_err_t err = trigger(nullptr);
+    if (m_last.triggered == 0) {
+        if (out) *out = m_last;
+        return err;
+    }
+
+    // Conversion time, bus lock released. Sleep rounded up to whole ticks
+    // (vTaskDelay() may wake up to a tick early, hence the loop); only a
+    // remainder up to I2C_GROUP_MAX_SPIN_US is spun
+    const int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+    int64_t until = m_last.ts_us + settle_us;
+    for (int64_t left; (left = until - esp_timer_get_time()) > 0;) {
+        if (left <= I2C_GROUP_MAX_SPIN_US) {
+            while (esp_timer_get_time() < until) {
+            }
+            break;
+        }
+        vTaskDelay((TickType_t)((left + tick_us - 1) / tick_us));
+    }
+
+    esp_err_t cerr = collect(out);
+    return err != ESP_OK ? err : cerr;
+}
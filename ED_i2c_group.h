@@ -0,0 +1,81 @@
+#ifndef ED_I2C_GROUP_H
+#define ED_I2C_GROUP_H
+
+#include "ED_i2c.h"
+
+#define I2C_GROUP_MAX_MEMBERS   8
+#define I2C_GROUP_MAX_TRIGGER   4    // bytes of a trigger write, register pointer included
+#define I2C_GROUP_MAX_READ      32   // result bytes per member (one batch burst)
+#define I2C_GROUP_MAX_SPIN_US   200  // longest settle remainder sample() busy-waits; longer ones sleep
+
+enum class I2CTriggerMode : uint8_t {
+    GENERAL_CALL,   // one write to address 0x00 reaches every member at once
+    BACK_TO_BACK,   // each member's trigger write, one after the other in one bus session
+};
+
+struct I2CGroupMember {
+    uint8_t  addr;
+    uint8_t  trigger[I2C_GROUP_MAX_TRIGGER];   // BACK_TO_BACK: write that starts a measurement
+    uint8_t  trigger_len;
+    uint8_t  reg;                              // first result register
+    uint8_t *data;                             // result destination
+    uint8_t  len;
+};
+
+struct I2CGroupSample {
+    int64_t  ts_us;       // shared timestamp: mean completion time of the trigger writes
+    uint32_t skew_us;     // first to last trigger completion, 0 for a general call
+    uint8_t  triggered;   // members the trigger reached
+    uint8_t  collected;   // members read back
+};
+
+/**
+ * @brief Devices of one bus that sample together.
+ *
+ * trigger() starts a measurement on every member as close together as the
+ * bus allows and takes one timestamp for all of them; collect() then reads
+ * every member's result in one batch.
+ *
+ * GENERAL_CALL sends one command to address 0x00, which every member that
+ * implements the general call acts on at the same STOP. BACK_TO_BACK is for
+ * devices without it: the handles are attached first and the trigger writes
+ * go out in one bus session with no retry, recovery or bookkeeping between
+ * them, so the skew is only the wire time of the writes. A member whose
+ * trigger fails is not retried (a late trigger would be misaligned): it is
+ * left out of the following collect() and reported by status().
+ */
+class I2CGroup {
+public:
+    // GENERAL_CALL sends `gc_cmd` (e.g. a device-specific "start conversion" byte)
+    I2CGroup(I2CBus &bus, I2CTriggerMode mode, const uint8_t *gc_cmd = nullptr, size_t gc_len = 0);
+    I2CGroup(const I2CGroup &) = delete;
+    I2CGroup &operator=(const I2CGroup &) = delete;
+
+    esp_err_t add(const I2CGroupMember &member, int *index = nullptr);
+
+    esp_err_t trigger(I2CGroupSample *out);
+    esp_err_t collect(I2CGroupSample *out);
+    // trigger(), wait `settle_us` for the conversions with the bus free, collect().
+    // The wait sleeps whole ticks, rounded up; a wait, or what is left of it,
+    // of up to I2C_GROUP_MAX_SPIN_US is spun instead
+    esp_err_t sample(uint32_t settle_us, I2CGroupSample *out);
+
+    // Result of the member's last trigger or collect
+    esp_err_t status(int index) const;
+    size_t    size() const { return m_count; }
+
+private:
+    esp_err_t trigger_general_call(I2CGroupSample *out);
+    esp_err_t trigger_back_to_back(I2CGroupSample *out);
+
+    I2CBus         &m_bus;
+    I2CTriggerMode  m_mode;
+    uint8_t         m_gc_cmd[I2C_GROUP_MAX_TRIGGER];
+    uint8_t         m_gc_len;
+    I2CGroupMember  m_members[I2C_GROUP_MAX_MEMBERS];
+    esp_err_t       m_status[I2C_GROUP_MAX_MEMBERS];
+    size_t          m_count;
+    I2CGroupSample  m_last;
+};
+
+#endif // ED_I2C_GROUP_H
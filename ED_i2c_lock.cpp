@@ -0,0 +1,213 @@
+#include "ED_i2c.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "ed_i2c";
+
+#define I2C_LOCK_AGING_MS   50   // a waiter gains one priority level per interval
+
+I2CArbiter::I2CArbiter()
+    : m_mutex(nullptr), m_mutex_buf(), m_owner(nullptr), m_depth(0), m_waiters(), m_seq(0),
+      m_mux(), m_stats()
+{
+    portMUX_INITIALIZE(&m_mux);
+    m_mutex = xSemaphoreCreateMutexStatic(&m_mutex_buf);
+    for (Waiter &w : m_waiters) w.wake = xSemaphoreCreateBinaryStatic(&w.wake_buf);
+}
+
+I2CArbiter::~I2CArbiter() {
+    for (Waiter &w : m_waiters) vSemaphoreDelete(w.wake);
+    vSemaphoreDelete(m_mutex);
+}
+
+// Highest priority after aging, oldest first among equals
+int I2CArbiter::best_waiter(int64_t now) const {
+    int best = -1;
+    uint64_t best_prio = 0;
+    for (int i = 0; i < I2C_LOCK_MAX_WAITERS; i++) {
+        const Waiter &w = m_waiters[i];
+        if (!w.used) continue;
+        uint64_t prio = w.prio + (uint64_t)(now - w.since_us) / (I2C_LOCK_AGING_MS * 1000);
+        if (best < 0 || prio > best_prio ||
+            (prio == best_prio && (int32_t)(w.seq - m_waiters[best].seq) < 0)) {
+            best = i;
+            best_prio = prio;
+        }
+    }
+    return best;
+}
+
+// Frees a waiter slot and names the waiter to wake next, so that it moves
+// onto the mutex (and lends its priority to the owner). m_mux held.
+void I2CArbiter::leave(int slot, bool granted, int64_t waited_us, SemaphoreHandle_t *wake_next) {
+    Waiter &w = m_waiters[slot];
+    w.used = false;
+    if (granted) {
+        m_stats.acquisitions++;
+        for (const Waiter &o : m_waiters) {
+            if (o.used && (int32_t)(o.seq - w.seq) < 0) {
+                m_stats.overtakes++;
+                break;
+            }
+        }
+    } else {
+        m_stats.timeouts++;
+    }
+    m_stats.total_wait_us += (uint64_t)waited_us;
+    if (waited_us > (int64_t)m_stats.max_wait_us) m_stats.max_wait_us = (uint32_t)waited_us;
+
+    int next = best_waiter(esp_timer_get_time());
+    *wake_next = next >= 0 ? m_waiters[next].wake : nullptr;
+}
+
+esp_err_t I2CArbiter::acquire(UBaseType_t priority, TickType_t timeout) {
+    TaskHandle_t me = xTaskGetCurrentTaskHandle();
+    if (m_owner == me) {
+        m_depth++;
+        return ESP_OK;
+    }
+    if (priority == I2C_PRIO_OF_TASK) priority = uxTaskPriorityGet(nullptr);
+
+    // Nobody queued: take a free mutex straight away. m_owner is only ever
+    // written by the task holding the mutex.
+    portENTER_CRITICAL(&m_mux);
+    bool waiting = false;
+    for (const Waiter &w : m_waiters) waiting |= w.used;
+    portEXIT_CRITICAL(&m_mux);
+    if (!waiting && xSemaphoreTake(m_mutex, 0) == pdTRUE) {
+        portENTER_CRITICAL(&m_mux);
+        m_owner = me;
+        m_stats.acquisitions++;
+        portEXIT_CRITICAL(&m_mux);
+        m_depth = 1;
+        return ESP_OK;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+    int slot = -1;
+    portENTER_CRITICAL(&m_mux);
+    for (int i = 0; i < I2C_LOCK_MAX_WAITERS; i++) {
+        Waiter &w = m_waiters[i];
+        if (w.used) continue;
+        w.used = true;
+        w.task = me;
+        w.prio = priority;
+        w.since_us = t0;
+        w.seq = m_seq++;
+        slot = i;
+        break;
+    }
+    m_stats.contended++;
+    portEXIT_CRITICAL(&m_mux);
+
+    if (slot < 0) {
+        // Waiter table full: queue on the mutex itself, in FreeRTOS priority order
+        bool got = xSemaphoreTake(m_mutex, timeout) == pdTRUE;
+        portENTER_CRITICAL(&m_mux);
+        if (got) {
+            m_owner = me;
+            m_stats.acquisitions++;
+        } else {
+            m_stats.timeouts++;
+        }
+        portEXIT_CRITICAL(&m_mux);
+        if (!got) return ESP_ERR_TIMEOUT;
+        m_depth = 1;
+        return ESP_OK;
+    }
+
+    Waiter &w = m_waiters[slot];
+    const TickType_t nap = pdMS_TO_TICKS(I2C_LOCK_AGING_MS) ? pdMS_TO_TICKS(I2C_LOCK_AGING_MS) : 1;
+    TickType_t start = xTaskGetTickCount();
+    bool granted = false;
+    while (1) {
+        TickType_t left = portMAX_DELAY;
+        if (timeout != portMAX_DELAY) {
+            TickType_t used = xTaskGetTickCount() - start;
+            left = used >= timeout ? 0 : timeout - used;
+        }
+        TickType_t wait = left < nap ? left : nap;
+
+        portENTER_CRITICAL(&m_mux);
+        bool best = best_waiter(esp_timer_get_time()) == slot;
+        portEXIT_CRITICAL(&m_mux);
+
+        // Only the best waiter queues on the mutex; the others sleep on
+        // their own semaphore and look again when woken or after a nap,
+        // since aging can change the order.
+        if (best && xSemaphoreTake(m_mutex, wait) == pdTRUE) {
+            granted = true;
+            break;
+        }
+        if (left == 0) break;
+        if (!best) xSemaphoreTake(w.wake, wait);
+    }
+
+    SemaphoreHandle_t next;
+    portENTER_CRITICAL(&m_mux);
+    if (granted) m_owner = me;
+    leave(slot, granted, esp_timer_get_time() - t0, &next);
+    portEXIT_CRITICAL(&m_mux);
+    xSemaphoreTake(w.wake, 0);   // drop a wake-up that came too late
+    if (next) xSemaphoreGive(next);
+    if (!granted) return ESP_ERR_TIMEOUT;
+    m_depth = 1;
+    return ESP_OK;
+}
+
+void I2CArbiter::release() {
+    if (m_owner != xTaskGetCurrentTaskHandle()) return;
+    if (--m_depth) return;
+
+    SemaphoreHandle_t next = nullptr;
+    portENTER_CRITICAL(&m_mux);
+    m_owner = nullptr;
+    int b = best_waiter(esp_timer_get_time());
+    if (b >= 0) next = m_waiters[b].wake;
+    portEXIT_CRITICAL(&m_mux);
+    xSemaphoreGive(m_mutex);
+    if (next) xSemaphoreGive(next);
+}
+
+void I2CArbiter::get_stats(I2CLockStats *out) const {
+    if (!out) return;
+    portENTER_CRITICAL(&m_mux);
+    *out = m_stats;
+    portEXIT_CRITICAL(&m_mux);
+}
+
+void I2CArbiter::reset_stats() {
+    portENTER_CRITICAL(&m_mux);
+    m_stats = {};
+    portEXIT_CRITICAL(&m_mux);
+}
+
+// ---------------------------------------------------------------------
+// I2CBus side
+// ---------------------------------------------------------------------
+I2CBusLock::I2CBusLock(I2CBus &bus, UBaseType_t priority) : m_bus(bus) {
+    uint32_t ms = bus.m_lock_timeout_ms;
+    m_status = bus.m_arbiter.acquire(priority, ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(ms));
+}
+
+I2CBusLock::~I2CBusLock() {
+    if (m_status == ESP_OK) m_bus.m_arbiter.release();
+}
+
+void I2CBus::set_lock_timeout(uint32_t timeout_ms) {
+    m_lock_timeout_ms = timeout_ms;
+}
+
+void I2CBus::get_lock_stats(I2CLockStats *out) const {
+    m_arbiter.get_stats(out);
+}
+
+void I2CBus::log_lock_stats() const {
+    I2CLockStats st;
+    m_arbiter.get_stats(&st);
+    ESP_LOGI(TAG, "port %d lock: %lu acquisitions, %lu contended, %lu overtakes, %lu timeouts, "
+             "wait avg %llu us max %lu us", (int)m_port, (unsigned long)st.acquisitions,
+             (unsigned long)st.contended, (unsigned long)st.overtakes, (unsigned long)st.timeouts,
+             (unsigned long long)(st.contended ? st.total_wait_us / st.contended : 0),
+             (unsigned long)st.max_wait_us);
+}
@@ -0,0 +1,75 @@
+#ifndef ED_I2C_LOCK_H
+#define ED_I2C_LOCK_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define I2C_LOCK_MAX_WAITERS   8
+#define I2C_PRIO_OF_TASK       ((UBaseType_t)-1)   // lock priority = caller's FreeRTOS priority
+
+struct I2CLockStats {
+    uint32_t acquisitions;   // outermost acquisitions, nested ones not counted
+    uint32_t contended;      // had to wait for another task
+    uint32_t timeouts;       // gave up after the lock timeout
+    uint32_t overtakes;      // granted ahead of a waiter that arrived earlier
+    uint32_t max_wait_us;
+    uint64_t total_wait_us;
+};
+
+/**
+ * @brief Priority-ordered, recursive bus lock.
+ *
+ * Waiters are served by priority, oldest first among equals, instead of in
+ * the order the scheduler happens to wake them. A waiter's priority grows by
+ * one every I2C_LOCK_AGING_MS, so a low-priority task can be delayed but
+ * not starved. The highest-ranked waiter blocks on a FreeRTOS mutex, so the
+ * current owner inherits its task priority and cannot be held off the CPU
+ * by medium-priority work while the waiter needs the bus.
+ *
+ * The lock is released between transactions, which is where a waiting
+ * control loop overtakes a long series of low-priority transfers.
+ */
+class I2CArbiter {
+public:
+    I2CArbiter();
+    ~I2CArbiter();
+    I2CArbiter(const I2CArbiter &) = delete;
+    I2CArbiter &operator=(const I2CArbiter &) = delete;
+
+    // ESP_ERR_TIMEOUT after `timeout`. Not from an ISR. Beyond
+    // I2C_LOCK_MAX_WAITERS waiting tasks, the extra ones queue on the mutex
+    // in plain FreeRTOS priority order.
+    esp_err_t acquire(UBaseType_t priority, TickType_t timeout);
+    void      release();
+    bool      held_by_me() const { return m_owner == xTaskGetCurrentTaskHandle(); }
+
+    void      get_stats(I2CLockStats *out) const;
+    void      reset_stats();
+
+private:
+    struct Waiter {
+        TaskHandle_t      task;
+        UBaseType_t       prio;
+        int64_t           since_us;
+        uint32_t          seq;
+        SemaphoreHandle_t wake;
+        StaticSemaphore_t wake_buf;
+        bool              used;
+    };
+
+    int  best_waiter(int64_t now) const;   // m_mux held
+    void leave(int slot, bool granted, int64_t waited_us, SemaphoreHandle_t *wake_next);
+
+    SemaphoreHandle_t     m_mutex;
+    StaticSemaphore_t     m_mutex_buf;
+    volatile TaskHandle_t m_owner;
+    uint32_t              m_depth;
+    Waiter                m_waiters[I2C_LOCK_MAX_WAITERS];
+    uint32_t              m_seq;
+    mutable portMUX_TYPE  m_mux;
+    I2CLockStats          m_stats;
+};
+
+#endif // ED_I2C_LOCK_H
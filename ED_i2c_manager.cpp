@@ -0,0 +1,104 @@
+#include "ED_i2c_manager.h"
+#include "esp_log.h"
+#include <cstring>
+#include <new>
+
+static const char *TAG = "ed_i2c_mgr";
+
+I2CBusManager::I2CBusManager() {
+    memset(m_buses, 0, sizeof(m_buses));
+    memset(m_route, NO_ROUTE, sizeof(m_route));
+}
+
+I2CBusManager::~I2CBusManager() {
+    for (I2CBus *&b : m_buses) {
+        delete b;   // stops its worker first
+        b = nullptr;
+    }
+}
+
+esp_err_t I2CBusManager::add_bus(const I2CBusConfig &cfg) {
+    if (cfg.port < 0 || cfg.port >= I2C_HP_PORT_COUNT) return ESP_ERR_INVALID_ARG;
+    if (m_buses[cfg.port]) return ESP_ERR_INVALID_STATE;
+
+    I2CBus *b = new (std::nothrow) I2CBus(cfg.port, cfg.sda, cfg.scl, cfg.freq);
+    if (!b) return ESP_ERR_NO_MEM;
+    esp_err_t err = b->status();   // bad port or pins
+    if (err == ESP_OK && cfg.worker_queue_len > 0) {
+        BaseType_t core = cfg.worker_core;
+        if (core == I2C_WORKER_CORE_BY_PORT) core = (BaseType_t)(cfg.port % portNUM_PROCESSORS);
+        err = b->start_worker(cfg.worker_queue_len, cfg.worker_priority, core);
+    }
+    if (err != ESP_OK) {
+        delete b;
+        return err;
+    }
+    m_buses[cfg.port] = b;
+    ESP_LOGI(TAG, "Bus %d: SDA=%d SCL=%d @ %lu Hz", (int)cfg.port, (int)cfg.sda, (int)cfg.scl,
+             (unsigned long)cfg.freq);
+    return ESP_OK;
+}
+
+I2CBus *I2CBusManager::bus(i2c_port_t port) const {
+    if (port < 0 || port >= I2C_HP_PORT_COUNT) return nullptr;
+    return m_buses[port];
+}
+
+esp_err_t I2CBusManager::assign(uint8_t addr, i2c_port_t port) {
+    if (addr >= I2C_ADDR_SLOTS || !bus(port)) return ESP_ERR_INVALID_ARG;
+    m_route[addr] = (uint8_t)port;
+    return ESP_OK;
+}
+
+I2CBus *I2CBusManager::bus_for(uint8_t addr) const {
+    if (addr >= I2C_ADDR_SLOTS || m_route[addr] == NO_ROUTE) return nullptr;
+    return m_buses[m_route[addr]];
+}
+
+// ---------------------------------------------------------------------
+// Routed calls
+// ---------------------------------------------------------------------
+esp_err_t I2CBusManager::write(uint8_t addr, const uint8_t *data, size_t len) {
+    I2CBus *b = bus_for(addr);
+    return b ? b->write(addr, data, len) : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t I2CBusManager::read(uint8_t addr, uint8_t *data, size_t len) {
+    I2CBus *b = bus_for(addr);
+    return b ? b->read(addr, data, len) : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t I2CBusManager::write_then_read(uint8_t addr, const uint8_t *wdata, size_t wlen,
+                                         uint8_t *rdata, size_t rlen) {
+    I2CBus *b = bus_for(addr);
+    return b ? b->write_then_read(addr, wdata, wlen, rdata, rlen) : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t I2CBusManager::submit(const I2CTransaction &t, TickType_t enqueue_wait) {
+    I2CBus *b = bus_for(t.addr);
+    return b ? b->submit(t, enqueue_wait) : ESP_ERR_NOT_FOUND;
+}
+
+// ---------------------------------------------------------------------
+// Stats
+// ---------------------------------------------------------------------
+esp_err_t I2CBusManager::get_stats(i2c_port_t port, I2CBusStats *out) const {
+    I2CBus *b = bus(port);
+    if (!b || !out) return ESP_ERR_INVALID_ARG;
+    b->get_stats(out);
+    return ESP_OK;
+}
+
+void I2CBusManager::log_stats() const {
+    for (int p = 0; p < I2C_HP_PORT_COUNT; p++) {
+        if (!m_buses[p]) continue;
+        I2CBusStats st;
+        m_buses[p]->get_stats(&st);
+        int devices = 0;
+        for (uint8_t a = 0; a < I2C_ADDR_SLOTS; a++) devices += (m_route[a] == p);
+        float secs = st.window_us / 1e6f;
+        ESP_LOGI(TAG, "Bus %d: %d devices, %lu ok / %lu failed, %.0f B/s, %.1f%% busy, %lu resets",
+                 p, devices, (unsigned long)st.transactions, (unsigned long)st.failures,
+                 secs > 0 ? st.bytes / secs : 0.0f, st.utilization(), (unsigned long)st.bus_resets);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef ED_I2C_MANAGER_H
+#define ED_I2C_MANAGER_H
+
+#include "ED_i2c.h"
+
+#define I2C_WORKER_CORE_BY_PORT  ((BaseType_t)-1)   // worker of port p on core p % portNUM_PROCESSORS
+
+struct I2CBusConfig {
+    i2c_port_t  port;
+    gpio_num_t  sda;
+    gpio_num_t  scl;
+    uint32_t    freq;
+    size_t      worker_queue_len = 0;               // 0 = no async worker
+    UBaseType_t worker_priority  = 10;
+    BaseType_t  worker_core      = I2C_WORKER_CORE_BY_PORT;   // or a core, or tskNO_AFFINITY
+};
+
+/**
+ * @brief Owns every HP I2C port of the chip and routes devices to them.
+ *
+ * Each bus recovers on its own peripheral, so buses run independently and,
+ * with workers pinned to different cores, in parallel. Devices are assigned
+ * to a port once; the routed calls then pick the right bus in O(1).
+ * A 7-bit address can be routed to one port only: use bus(port) directly
+ * for the same address on two buses.
+ */
+class I2CBusManager {
+public:
+    I2CBusManager();
+    ~I2CBusManager();
+    I2CBusManager(const I2CBusManager &) = delete;
+    I2CBusManager &operator=(const I2CBusManager &) = delete;
+
+    esp_err_t add_bus(const I2CBusConfig &cfg);
+    I2CBus   *bus(i2c_port_t port) const;
+
+    esp_err_t assign(uint8_t dev_addr, i2c_port_t port);
+    I2CBus   *bus_for(uint8_t dev_addr) const;
+
+    // Routed counterparts of the I2CBus calls
+    esp_err_t write(uint8_t dev_addr, const uint8_t *data, size_t len);
+    esp_err_t read(uint8_t dev_addr, uint8_t *data, size_t len);
+    esp_err_t write_then_read(uint8_t dev_addr,
+                              const uint8_t *write_data, size_t write_len,
+                              uint8_t *read_data, size_t read_len);
+    esp_err_t submit(const I2CTransaction &t, TickType_t enqueue_wait = 0);
+
+    esp_err_t get_stats(i2c_port_t port, I2CBusStats *out) const;
+    void      log_stats() const;
+
+private:
+    static constexpr uint8_t NO_ROUTE = 0xFF;
+
+    I2CBus  *m_buses[I2C_HP_PORT_COUNT];
+    uint8_t  m_route[I2C_ADDR_SLOTS];   // address -> port, NO_ROUTE if unassigned
+};
+
+#endif // ED_I2C_MANAGER_H
@@ -0,0 +1,145 @@
+#include "ED_i2c.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "ed_i2c";
+
+// ---------------------------------------------------------------------
+// Hot path (called once per attempt by run_retry())
+// ---------------------------------------------------------------------
+static inline int latency_bucket(uint32_t us) {
+    int b = 31 - __builtin_clz(us | 1);
+    return b < I2C_LATENCY_BUCKETS ? b : I2C_LATENCY_BUCKETS - 1;
+}
+
+void I2CBus::record_attempt(DeviceSlot &slot, uint32_t us, size_t bytes, bool ok) {
+    uint32_t seq = m_stats_seq.load(std::memory_order_relaxed);
+    m_stats_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_stats.busy_us += us;
+    if (ok) {
+        m_stats.transactions++;
+        m_stats.bytes += bytes;
+    } else {
+        m_stats.failures++;
+    }
+    m_stats_seq.store(seq + 2, std::memory_order_release);
+
+    if (slot.metrics == NO_METRICS) return;
+    DeviceCounters &c = m_dev_metrics[slot.metrics];
+    if (ok) {
+        c.transactions.fetch_add(1, std::memory_order_relaxed);
+        c.bytes.fetch_add((uint32_t)bytes, std::memory_order_relaxed);
+    } else {
+        c.failures.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (us) c.latency_hist[latency_bucket(us)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void I2CBus::record_bus_reset() {
+    uint32_t seq = m_stats_seq.load(std::memory_order_relaxed);
+    m_stats_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_stats.bus_resets++;
+    m_stats_seq.store(seq + 2, std::memory_order_release);
+}
+
+void I2CBus::assign_metrics(uint8_t addr) {
+    uint8_t idx = m_dev_metrics_used.load(std::memory_order_relaxed);
+    if (idx >= I2C_METRICS_MAX_DEVICES) return;
+    m_dev_metrics[idx].addr = addr;
+    m_slots[addr].metrics = idx;
+    m_dev_metrics_used.store(idx + 1, std::memory_order_release);
+}
+
+// ---------------------------------------------------------------------
+// Snapshots
+// ---------------------------------------------------------------------
+void I2CBus::get_stats(I2CBusStats *out) const {
+    if (!out) return;
+    uint32_t s0, s1;
+    do {
+        s0 = m_stats_seq.load(std::memory_order_acquire);
+        *out = m_stats;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        s1 = m_stats_seq.load(std::memory_order_relaxed);
+    } while ((s0 & 1) || s0 != s1);
+    out->window_us = esp_timer_get_time() - m_stats_start_us;
+}
+
+void I2CBus::read_counters(const DeviceCounters &c, I2CDeviceMetrics *out) {
+    out->addr = c.addr;
+    out->transactions = c.transactions.load(std::memory_order_relaxed);
+    out->failures = c.failures.load(std::memory_order_relaxed);
+    out->bytes = c.bytes.load(std::memory_order_relaxed);
+    out->soft_recoveries = c.soft_recoveries.load(std::memory_order_relaxed);
+    out->bus_recoveries = c.bus_recoveries.load(std::memory_order_relaxed);
+    for (int i = 0; i < I2C_LATENCY_BUCKETS; i++)
+        out->latency_hist[i] = c.latency_hist[i].load(std::memory_order_relaxed);
+}
+
+esp_err_t I2CBus::get_device_metrics(uint8_t addr, I2CDeviceMetrics *out) const {
+    if (addr >= I2C_ADDR_SLOTS || !out) return ESP_ERR_INVALID_ARG;
+    uint8_t idx = m_slots[addr].metrics;
+    if (idx == NO_METRICS) return ESP_ERR_NOT_FOUND;
+    read_counters(m_dev_metrics[idx], out);
+    out->scl_hz = device_hz(m_slots[addr]);
+    return ESP_OK;
+}
+
+void I2CBus::get_metrics(I2CMetricsSnapshot *out) const {
+    if (!out) return;
+    get_stats(&out->bus);
+    out->device_count = m_dev_metrics_used.load(std::memory_order_acquire);
+    for (size_t i = 0; i < out->device_count; i++) {
+        read_counters(m_dev_metrics[i], &out->devices[i]);
+        out->devices[i].scl_hz = device_hz(m_slots[m_dev_metrics[i].addr]);
+    }
+}
+
+// Under the bus lock: record_attempt() and record_bus_reset() are the only
+// other writers and rely on being alone on m_stats_seq
+esp_err_t I2CBus::reset_stats() {
+    I2CBusLock lock(*this);
+    if (lock.status() != ESP_OK) return lock.status();
+    uint32_t seq = m_stats_seq.load(std::memory_order_relaxed);
+    m_stats_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_stats = {};
+    m_stats_start_us = esp_timer_get_time();
+    m_stats_seq.store(seq + 2, std::memory_order_release);
+
+    for (DeviceCounters &c : m_dev_metrics) {
+        c.transactions.store(0, std::memory_order_relaxed);
+        c.failures.store(0, std::memory_order_relaxed);
+        c.bytes.store(0, std::memory_order_relaxed);
+        c.soft_recoveries.store(0, std::memory_order_relaxed);
+        c.bus_recoveries.store(0, std::memory_order_relaxed);
+        for (auto &h : c.latency_hist) h.store(0, std::memory_order_relaxed);
+    }
+    return ESP_OK;
+}
+
+void I2CBus::log_metrics() const {
+    I2CMetricsSnapshot snap;
+    get_metrics(&snap);
+    ESP_LOGI(TAG, "port %d: %lu ok / %lu failed, %.0f B/s, %.1f%% occupied, %lu bus resets",
+             (int)m_port, (unsigned long)snap.bus.transactions, (unsigned long)snap.bus.failures,
+             snap.bus.bytes_per_s(), snap.bus.utilization(), (unsigned long)snap.bus.bus_resets);
+
+    for (size_t i = 0; i < snap.device_count; i++) {
+        const I2CDeviceMetrics &d = snap.devices[i];
+        // Median bucket of the latency histogram
+        uint32_t total = 0, acc = 0;
+        for (uint32_t h : d.latency_hist) total += h;
+        int median = 0;
+        for (; median < I2C_LATENCY_BUCKETS; median++) {
+            acc += d.latency_hist[median];
+            if (acc * 2 >= total) break;
+        }
+        ESP_LOGI(TAG, "  0x%02X @ %lu kHz: %lu ok / %lu failed, %lu B, soft=%lu bus=%lu, p50 < %lu us",
+                 d.addr, (unsigned long)(d.scl_hz / 1000), (unsigned long)d.transactions, (unsigned long)d.failures,
+                 (unsigned long)d.bytes, (unsigned long)d.soft_recoveries,
+                 (unsigned long)d.bus_recoveries, total ? (unsigned long)(2u << median) : 0ul);
+    }
+}
@@ -0,0 +1,148 @@
+#include "ED_i2c_regcache.h"
+#include "esp_log.h"
+#include <cstring>
+
+static const char *TAG = "ed_i2c_cache";
+
+I2CRegCache::I2CRegCache(I2CBus &bus, uint8_t dev_addr, uint8_t reg_width, bool big_endian)
+    : m_bus(bus), m_addr(dev_addr), m_width(reg_width == 2 ? 2 : 1), m_big_endian(big_endian),
+      m_hits(0), m_misses(0), m_writes_skipped(0)
+{
+    memset(m_value, 0, sizeof(m_value));
+    memset(m_cacheable, 0, sizeof(m_cacheable));
+    memset(m_valid, 0, sizeof(m_valid));
+    memset(m_dirty, 0, sizeof(m_dirty));
+    memset(m_written, 0, sizeof(m_written));
+    if (m_bus.attach_reg_cache(m_addr, this) != ESP_OK)
+        ESP_LOGE(TAG, "0x%02X: cannot attach cache (address taken or invalid)", m_addr);
+}
+
+I2CRegCache::~I2CRegCache() {
+    m_bus.detach_reg_cache(m_addr, this);
+}
+
+void I2CRegCache::set_cacheable(uint8_t reg, bool cacheable) {
+    set(m_cacheable, reg, cacheable);
+    if (!cacheable) {
+        set(m_valid, reg, false);
+        set(m_dirty, reg, false);
+        set(m_written, reg, false);
+    }
+}
+
+void I2CRegCache::set_cacheable_range(uint8_t first, uint8_t last, bool cacheable) {
+    for (unsigned r = first; r <= last; r++) set_cacheable((uint8_t)r, cacheable);
+}
+
+// ---------------------------------------------------------------------
+// Raw register access (pointer write, then `m_width` bytes)
+// ---------------------------------------------------------------------
+esp_err_t I2CRegCache::bus_read(uint8_t reg, uint16_t &value) {
+    uint8_t raw[2] = {0, 0};
+    esp_err_t err = m_bus.write_then_read(m_addr, &reg, 1, raw, m_width);
+    if (err != ESP_OK) return err;
+    if (m_width == 1) value = raw[0];
+    else value = m_big_endian ? (uint16_t)((raw[0] << 8) | raw[1]) : (uint16_t)((raw[1] << 8) | raw[0]);
+    return ESP_OK;
+}
+
+esp_err_t I2CRegCache::bus_write(uint8_t reg, uint16_t value, bool raw) {
+    uint8_t buf[3] = {reg, 0, 0};
+    if (m_width == 1) {
+        buf[1] = (uint8_t)value;
+    } else if (m_big_endian) {
+        buf[1] = (uint8_t)(value >> 8);
+        buf[2] = (uint8_t)value;
+    } else {
+        buf[1] = (uint8_t)value;
+        buf[2] = (uint8_t)(value >> 8);
+    }
+    if (raw) return m_bus.raw_write(m_addr, buf, 1 + m_width);
+    return m_bus.write(m_addr, buf, 1 + m_width);
+}
+
+// ---------------------------------------------------------------------
+// Cached access
+// ---------------------------------------------------------------------
+esp_err_t I2CRegCache::read(uint8_t reg, uint16_t &value) {
+    bool cacheable = test(m_cacheable, reg);
+    if (cacheable && test(m_valid, reg)) {
+        value = m_value[reg];
+        m_hits++;
+        return ESP_OK;
+    }
+    m_misses++;
+    esp_err_t err = bus_read(reg, value);
+    if (err == ESP_OK && cacheable) {
+        m_value[reg] = value;
+        set(m_valid, reg, true);
+    }
+    return err;
+}
+
+esp_err_t I2CRegCache::write(uint8_t reg, uint16_t value) {
+    if (!test(m_cacheable, reg)) return bus_write(reg, value);
+
+    if (test(m_valid, reg) && !test(m_dirty, reg) && m_value[reg] == value) {
+        m_writes_skipped++;
+        return ESP_OK;
+    }
+    m_value[reg] = value;
+    set(m_valid, reg, true);
+    set(m_written, reg, true);
+    esp_err_t err = bus_write(reg, value);
+    set(m_dirty, reg, err != ESP_OK);   // keep it for the next flush/replay
+    return err;
+}
+
+esp_err_t I2CRegCache::update_bits(uint8_t reg, uint16_t mask, uint16_t bits) {
+    uint16_t cur;
+    esp_err_t err = read(reg, cur);
+    if (err != ESP_OK) return err;
+    return write(reg, (uint16_t)((cur & ~mask) | (bits & mask)));
+}
+
+void I2CRegCache::stage(uint8_t reg, uint16_t value) {
+    if (!test(m_cacheable, reg)) set_cacheable(reg);
+    if (test(m_valid, reg) && m_value[reg] == value) return;
+    m_value[reg] = value;
+    set(m_valid, reg, true);
+    set(m_written, reg, true);
+    set(m_dirty, reg, true);
+}
+
+esp_err_t I2CRegCache::flush() {
+    esp_err_t first_err = ESP_OK;
+    for (unsigned r = 0; r < 256; r++) {
+        if (!test(m_dirty, (uint8_t)r)) continue;
+        esp_err_t err = bus_write((uint8_t)r, m_value[r]);
+        if (err == ESP_OK) set(m_dirty, (uint8_t)r, false);
+        else if (first_err == ESP_OK) first_err = err;
+    }
+    return first_err;
+}
+
+esp_err_t I2CRegCache::replay() {
+    return replay(false);
+}
+
+esp_err_t I2CRegCache::replay(bool raw) {
+    esp_err_t first_err = ESP_OK;
+    for (unsigned r = 0; r < 256; r++) {
+        if (!test(m_written, (uint8_t)r)) continue;
+        // A raw replay does not wait out a timeout per register: after the
+        // first failure the rest only stays dirty for the next flush/replay
+        esp_err_t err = (raw && first_err != ESP_OK) ? first_err : bus_write((uint8_t)r, m_value[r], raw);
+        set(m_dirty, (uint8_t)r, err != ESP_OK);
+        if (err != ESP_OK && first_err == ESP_OK) first_err = err;
+    }
+    if (first_err != ESP_OK)
+        ESP_LOGW(TAG, "0x%02X: replay incomplete (%s)", m_addr, esp_err_to_name(first_err));
+    return first_err;
+}
+
+void I2CRegCache::invalidate() {
+    memset(m_valid, 0, sizeof(m_valid));
+    memset(m_dirty, 0, sizeof(m_dirty));
+    memset(m_written, 0, sizeof(m_written));
+}
@@ -0,0 +1,77 @@
+#ifndef ED_I2C_REGCACHE_H
+#define ED_I2C_REGCACHE_H
+
+#include "ED_i2c.h"
+#include <cstdint>
+
+/**
+ * @brief Opt-in register shadow cache for one device on an I2CBus.
+ *
+ * Registers are volatile (always read from the device) unless marked
+ * cacheable. For cacheable registers:
+ *  - reads are served from the shadow once it holds a value,
+ *  - writes of an unchanged value are skipped,
+ *  - a failed write keeps the value and stays dirty until flush()/replay(),
+ *  - after I2CBus::recover_bus() every register written through the cache
+ *    (the device configuration) is replayed; values only read are not.
+ *
+ * Register address is 8 bit; register width is 1 or 2 bytes (as on the wire).
+ * All storage is inline, no heap.
+ */
+class I2CRegCache {
+public:
+    I2CRegCache(I2CBus &bus, uint8_t dev_addr, uint8_t reg_width = 1, bool big_endian = true);
+    ~I2CRegCache();
+    I2CRegCache(const I2CRegCache &) = delete;
+    I2CRegCache &operator=(const I2CRegCache &) = delete;
+
+    void set_cacheable(uint8_t reg, bool cacheable = true);
+    void set_cacheable_range(uint8_t first, uint8_t last, bool cacheable = true);
+
+    esp_err_t read(uint8_t reg, uint16_t &value);
+    esp_err_t write(uint8_t reg, uint16_t value);
+    esp_err_t update_bits(uint8_t reg, uint16_t mask, uint16_t bits);
+
+    // Write-back: stage() only updates the shadow, flush() sends dirty registers
+    void      stage(uint8_t reg, uint16_t value);
+    esp_err_t flush();
+    // Rewrites every register written through the cache (called automatically after a bus reset)
+    esp_err_t replay();
+    void      invalidate();
+
+    uint8_t  address() const { return m_addr; }
+    uint32_t hits() const { return m_hits; }
+    uint32_t misses() const { return m_misses; }
+    uint32_t writes_skipped() const { return m_writes_skipped; }
+
+private:
+    static bool test(const uint32_t *bits, uint8_t reg) { return bits[reg >> 5] & (1u << (reg & 31)); }
+    static void set(uint32_t *bits, uint8_t reg, bool on) {
+        if (on) bits[reg >> 5] |= (1u << (reg & 31));
+        else    bits[reg >> 5] &= ~(1u << (reg & 31));
+    }
+    friend class I2CBus;
+
+    esp_err_t bus_read(uint8_t reg, uint16_t &value);
+    esp_err_t bus_write(uint8_t reg, uint16_t value, bool raw = false);
+    // raw: single backend writes with no retry or recovery, as I2CBus
+    // replays after its own recovery; stops at the first failure
+    esp_err_t replay(bool raw);
+
+    I2CBus  &m_bus;
+    uint8_t  m_addr;
+    uint8_t  m_width;
+    bool     m_big_endian;
+
+    uint16_t m_value[256];
+    uint32_t m_cacheable[8];   // one bit per register
+    uint32_t m_valid[8];
+    uint32_t m_dirty[8];
+    uint32_t m_written[8];     // configuration to replay
+
+    uint32_t m_hits;
+    uint32_t m_misses;
+    uint32_t m_writes_skipped;
+};
+
+#endif // ED_I2C_REGCACHE_H
@@ -0,0 +1,251 @@
+#ifndef ED_I2C_REGMAP_H
+#define ED_I2C_REGMAP_H
+
+/**
+ * @file ED_i2c_regmap.h
+ * @brief Typed register maps for I2C device drivers, resolved at compile time.
+ *
+ * A driver declares each register once (address, width, byte order, access)
+ * and each bitfield once (register, shift, width, value type). I2CRegMap
+ * turns accesses into the plain I2CBus calls a hand-written driver would
+ * make: no tables, no virtual calls, nothing allocated. Writing a read-only
+ * register or reading a write-only one does not compile, and a list of
+ * registers that sit next to each other is read or written as one burst.
+ *
+ * @code
+ * struct MPU6050 {
+ *     static constexpr uint8_t addr = 0x68;
+ *     static constexpr I2CRegLayout layout = I2CRegLayout::BYTE_ADDRESSED;
+ *     using AccelX   = I2CReg<0x3B, int16_t, I2CRegAccess::RO>;
+ *     using AccelY   = I2CReg<0x3D, int16_t, I2CRegAccess::RO>;
+ *     using PwrMgmt1 = I2CReg<0x6B, uint8_t>;
+ *     using Sleep    = I2CField<PwrMgmt1, 6, 1, bool>;
+ * };
+ * I2CRegMap<MPU6050> imu(bus);
+ * imu.write_field<MPU6050::Sleep>(false);           // read-modify-write under the bus lock
+ * int16_t ax, ay;
+ * imu.read<MPU6050::AccelX, MPU6050::AccelY>(&ax, &ay);   // one 4-byte burst
+ * @endcode
+ */
+
+#include "ED_i2c.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+enum class I2CRegAccess : uint8_t { RO, WO, RW };
+enum class I2CRegEndian : uint8_t { BIG, LITTLE };
+
+/// How the device's register pointer advances during a burst
+enum class I2CRegLayout : uint8_t {
+    BYTE_ADDRESSED,      // one address per byte: a 16-bit register spans two addresses
+    REG_ADDRESSED,       // one address per register, whatever its width
+    NO_AUTO_INCREMENT,   // every register needs its own transfer
+};
+
+/**
+ * @brief One register. `T` is the integer it decodes to; `Width` the bytes it
+ * takes on the wire (a 24-bit value is `I2CReg<addr, int32_t, RO, BIG, 3>`).
+ * Signed values narrower than `T` are sign-extended.
+ */
+template <uint8_t Addr, typename T, I2CRegAccess Access = I2CRegAccess::RW,
+          I2CRegEndian Endian = I2CRegEndian::BIG, size_t Width = sizeof(T)>
+struct I2CReg {
+    static_assert(std::is_integral<T>::value, "register value type must be an integer");
+    static_assert(Width >= 1 && Width <= sizeof(T), "register width does not fit its value type");
+
+    using value_type = T;
+    static constexpr uint8_t addr = Addr;
+    static constexpr size_t  width = Width;
+    static constexpr bool    readable = Access != I2CRegAccess::WO;
+    static constexpr bool    writable = Access != I2CRegAccess::RO;
+
+    static constexpr T decode(const uint8_t *b) {
+        using U = typename std::make_unsigned<T>::type;
+        U v = 0;
+        for (size_t i = 0; i < Width; i++) {
+            size_t k = Endian == I2CRegEndian::BIG ? i : Width - 1 - i;
+            v = (U)((v << 8) | b[k]);
+        }
+        if constexpr (std::is_signed<T>::value && Width < sizeof(T)) {
+            constexpr unsigned pad = (unsigned)(sizeof(T) - Width) * 8;
+            return (T)((T)(v << pad) >> pad);
+        }
+        return (T)v;
+    }
+
+    static constexpr void encode(T value, uint8_t *b) {
+        using U = typename std::make_unsigned<T>::type;
+        U v = (U)value;
+        for (size_t i = 0; i < Width; i++) {
+            size_t k = Endian == I2CRegEndian::BIG ? Width - 1 - i : i;
+            b[k] = (uint8_t)(v & 0xFF);
+            v = (U)(v >> 8);
+        }
+    }
+};
+
+/// A bitfield of a register. `V` may be an integer, bool or an enum.
+template <typename Reg, unsigned Shift, unsigned Bits, typename V = typename Reg::value_type>
+struct I2CField {
+    using reg = Reg;
+    using raw_type = typename std::make_unsigned<typename Reg::value_type>::type;
+    using value_type = V;
+    static_assert(Bits >= 1 && Shift + Bits <= Reg::width * 8, "field does not fit its register");
+
+    static constexpr raw_type mask = (raw_type)((((uint64_t)1 << Bits) - 1) << Shift);
+
+    static constexpr V get(typename Reg::value_type raw) {
+        return (V)(((raw_type)raw & mask) >> Shift);
+    }
+    static constexpr typename Reg::value_type set(typename Reg::value_type raw, V v) {
+        return (typename Reg::value_type)(((raw_type)raw & (raw_type)~mask) |
+                                          (((raw_type)v << Shift) & mask));
+    }
+};
+
+namespace i2c_regmap_detail {
+
+template <typename First, typename...>
+struct first { using type = First; };
+
+template <I2CRegLayout L, typename A, typename B>
+constexpr bool adjacent() {
+    if constexpr (L == I2CRegLayout::BYTE_ADDRESSED) return (unsigned)A::addr + A::width == B::addr;
+    else if constexpr (L == I2CRegLayout::REG_ADDRESSED) return (unsigned)A::addr + 1 == B::addr;
+    else return false;
+}
+
+// Bytes of the contiguous run that starts with Reg
+template <I2CRegLayout L, typename Reg, typename... Rest>
+constexpr size_t run_bytes() {
+    if constexpr (sizeof...(Rest) == 0) {
+        return Reg::width;
+    } else if constexpr (adjacent<L, Reg, typename first<Rest...>::type>()) {
+        return Reg::width + run_bytes<L, Rest...>();
+    } else {
+        return Reg::width;
+    }
+}
+
+template <typename Dev, typename = void>
+struct retry_of { using type = I2CRetryDefault; };
+template <typename Dev>
+struct retry_of<Dev, std::void_t<typename Dev::retry>> { using type = typename Dev::retry; };
+
+template <typename...>
+struct same_reg : std::true_type {};
+template <typename A, typename B, typename... Rest>
+struct same_reg<A, B, Rest...>
+    : std::integral_constant<bool, std::is_same<typename A::reg, typename B::reg>::value &&
+                                       same_reg<B, Rest...>::value> {};
+
+} // namespace i2c_regmap_detail
+
+/**
+ * @brief Typed accessors for the device described by `Dev`, which provides
+ * `static constexpr uint8_t addr` and `static constexpr I2CRegLayout layout`,
+ * and optionally `using retry = <policy>` (ED_i2c_retry.h, default
+ * I2CRetryDefault).
+ */
+template <typename Dev>
+class I2CRegMap {
+public:
+    explicit I2CRegMap(I2CBus &bus) : m_bus(bus) {}
+
+    // Reads the registers in the order given; runs of adjacent registers go
+    // out as one write_then_read each.
+    template <typename... Regs>
+    esp_err_t read(typename Regs::value_type *...out) {
+        static_assert(sizeof...(Regs) > 0, "no register to read");
+        static_assert((Regs::readable && ...), "register is write-only");
+        return read_from<Regs...>(out...);
+    }
+
+    // Writes the registers in the order given; runs of adjacent registers go
+    // out as one write each.
+    template <typename... Regs>
+    esp_err_t write(typename Regs::value_type... value) {
+        static_assert(sizeof...(Regs) > 0, "no register to write");
+        static_assert((Regs::writable && ...), "register is read-only");
+        return write_from<Regs...>(value...);
+    }
+
+    template <typename Field>
+    esp_err_t read_field(typename Field::value_type *out) {
+        typename Field::reg::value_type raw;
+        esp_err_t err = read<typename Field::reg>(&raw);
+        if (err == ESP_OK) *out = Field::get(raw);
+        return err;
+    }
+
+    // Read-modify-write of one or more fields of the same register, under
+    // the bus lock so no other task writes the register in between.
+    template <typename... Fields>
+    esp_err_t write_field(typename Fields::value_type... value) {
+        static_assert(sizeof...(Fields) > 0, "no field to write");
+        static_assert(i2c_regmap_detail::same_reg<Fields...>::value, "fields belong to different registers");
+        using Reg = typename i2c_regmap_detail::first<Fields...>::type::reg;
+        static_assert(Reg::readable && Reg::writable, "read-modify-write needs a read-write register");
+
+        I2CBusLock lock(m_bus);
+        if (lock.status() != ESP_OK) return lock.status();
+        typename Reg::value_type raw;
+        esp_err_t err = read<Reg>(&raw);
+        if (err != ESP_OK) return err;
+        ((raw = Fields::set(raw, value)), ...);
+        return write<Reg>(raw);
+    }
+
+private:
+    template <typename Reg, typename... Rest>
+    esp_err_t read_from(typename Reg::value_type *out, typename Rest::value_type *...rest) {
+        uint8_t buf[i2c_regmap_detail::run_bytes<Dev::layout, Reg, Rest...>()];
+        uint8_t reg = Reg::addr;
+        esp_err_t err = m_bus.write_then_read<Policy>(Dev::addr, &reg, 1, buf, sizeof(buf));
+        if (err != ESP_OK) return err;
+        return decode_run<0, Reg, Rest...>(buf, out, rest...);
+    }
+
+    template <size_t Off, typename Reg, typename... Rest>
+    esp_err_t decode_run(const uint8_t *buf, typename Reg::value_type *out, typename Rest::value_type *...rest) {
+        *out = Reg::decode(buf + Off);
+        if constexpr (sizeof...(Rest) == 0) {
+            return ESP_OK;
+        } else if constexpr (i2c_regmap_detail::adjacent<Dev::layout, Reg,
+                                                         typename i2c_regmap_detail::first<Rest...>::type>()) {
+            return decode_run<Off + Reg::width, Rest...>(buf, rest...);
+        } else {
+            return read_from<Rest...>(rest...);
+        }
+    }
+
+    template <typename Reg, typename... Rest>
+    esp_err_t write_from(typename Reg::value_type value, typename Rest::value_type... rest) {
+        uint8_t buf[1 + i2c_regmap_detail::run_bytes<Dev::layout, Reg, Rest...>()];
+        buf[0] = Reg::addr;
+        return encode_run<1, Reg, Rest...>(buf, value, rest...);
+    }
+
+    template <size_t Off, typename Reg, typename... Rest>
+    esp_err_t encode_run(uint8_t *buf, typename Reg::value_type value, typename Rest::value_type... rest) {
+        Reg::encode(value, buf + Off);
+        if constexpr (sizeof...(Rest) > 0) {
+            if constexpr (i2c_regmap_detail::adjacent<Dev::layout, Reg,
+                                                      typename i2c_regmap_detail::first<Rest...>::type>()) {
+                return encode_run<Off + Reg::width, Rest...>(buf, rest...);
+            } else {
+                esp_err_t err = m_bus.write<Policy>(Dev::addr, buf, Off + Reg::width);
+                if (err != ESP_OK) return err;
+                return write_from<Rest...>(rest...);
+            }
+        }
+        return m_bus.write<Policy>(Dev::addr, buf, Off + Reg::width);
+    }
+
+    using Policy = typename i2c_regmap_detail::retry_of<Dev>::type;
+
+    I2CBus &m_bus;
+};
+
+#endif // ED_I2C_REGMAP_H
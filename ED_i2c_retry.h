@@ -0,0 +1,81 @@
+#ifndef ED_I2C_RETRY_H
+#define ED_I2C_RETRY_H
+
+#include "esp_timer.h"
+#include <cstdint>
+
+#define I2C_MAX_RETRY_ATTEMPTS   3   // attempts per call before the device is quarantined
+#define PER_DEVICE_RETRY_LIMIT   3   // consecutive failures handled by soft recovery before the bus ladder
+
+/// What a failed attempt triggers before the next one
+enum class I2CRetryRecovery : uint8_t {
+    NONE,            // nothing: the bus is left alone
+    SOFT_THEN_BUS,   // per-device soft recovery; the bus ladder if that is not possible or fails,
+                     // after `soft_limit` consecutive failures and before the last attempt
+    BUS,             // the bus recovery ladder straight away
+};
+
+/*
+ * Retry policies for I2CBus::write<Policy>() and friends, I2CDevice<Policy>
+ * and I2CRegMap. A policy is a type with these members, all evaluated at
+ * compile time except backoff_ms():
+ *
+ *   static constexpr int              max_attempts;   // 0 = until the call's deadline
+ *   static constexpr I2CRetryRecovery recovery;
+ *   static constexpr uint8_t          soft_limit;     // SOFT_THEN_BUS only
+ *   static constexpr bool             quarantine;     // trip the breaker when attempts run out
+ *   static uint32_t backoff_ms(int failed_attempts);  // pause before the next attempt, 0 = none
+ *
+ * The retry loop is instantiated once per policy, so unused steps compile
+ * away: I2CNoRetry is a single backend call plus the bookkeeping.
+ */
+
+/// Immediate attempts, soft recovery then the bus ladder, quarantine at the end
+template <int Attempts = I2C_MAX_RETRY_ATTEMPTS, uint8_t SoftLimit = PER_DEVICE_RETRY_LIMIT>
+struct I2CBoundedRetry {
+    static constexpr int              max_attempts = Attempts;
+    static constexpr I2CRetryRecovery recovery = I2CRetryRecovery::SOFT_THEN_BUS;
+    static constexpr uint8_t          soft_limit = SoftLimit;
+    static constexpr bool             quarantine = true;
+    static constexpr uint32_t backoff_ms(int) { return 0; }
+};
+
+/// What write(), read(), write_then_read() and transfer_batch() use
+using I2CRetryDefault = I2CBoundedRetry<>;
+
+/// One attempt, no recovery, no quarantine: for reads where a late sample is
+/// worth less than a missing one. Failures still count for the next caller.
+struct I2CNoRetry {
+    static constexpr int              max_attempts = 1;
+    static constexpr I2CRetryRecovery recovery = I2CRetryRecovery::NONE;
+    static constexpr uint8_t          soft_limit = 0;
+    static constexpr bool             quarantine = false;
+    static constexpr uint32_t backoff_ms(int) { return 0; }
+};
+
+/// Bounded retry with a pause between attempts: BaseMs doubling up to MaxMs,
+/// the second half of it random, so devices that fail together do not retry
+/// in lockstep. The bus lock is released during the pause.
+template <int Attempts = I2C_MAX_RETRY_ATTEMPTS, uint32_t BaseMs = 2, uint32_t MaxMs = 50>
+struct I2CBackoffRetry : I2CBoundedRetry<Attempts> {
+    static uint32_t backoff_ms(int failed) {
+        uint32_t ms = BaseMs;
+        for (int i = 1; i < failed && ms < MaxMs; i++) ms *= 2;
+        if (ms > MaxMs) ms = MaxMs;
+        // xorshift of the clock: enough to spread retries, no RNG needed
+        uint32_t x = (uint32_t)esp_timer_get_time() | 1u;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return ms - ms / 2 + x % (ms / 2 + 1);
+    }
+};
+
+/// Straight to the bus recovery ladder after every failure, for devices
+/// known to wedge the bus rather than lose their configuration
+template <int Attempts = 2>
+struct I2CEscalateRetry : I2CBoundedRetry<Attempts> {
+    static constexpr I2CRetryRecovery recovery = I2CRetryRecovery::BUS;
+};
+
+#endif // ED_I2C_RETRY_H
@@ -0,0 +1,88 @@
+#include "ED_i2c.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "ed_i2c";
+
+#define I2C_SCAN_MIN_TMO_MS   1    // a NACK comes back within one address frame
+#define I2C_SCAN_MAX_TMO_MS   50   // longest clock stretch tolerated while scanning
+
+// ---------------------------------------------------------------------
+// Presence cache
+// An ACK anywhere proves the device is there; only a probe NACK proves it
+// is not. Any other failure (data NACK, timeout, stuck bus) just forgets
+// the address so the next scan probes it again.
+// ---------------------------------------------------------------------
+void I2CBus::note_presence(uint8_t addr, esp_err_t err) {
+    if (err == ESP_OK) {
+        m_present.set(addr);
+        m_seen.set(addr);
+    } else if (err == ESP_ERR_NOT_FOUND) {
+        m_present.set(addr, false);
+        m_seen.set(addr);
+    } else {
+        m_seen.set(addr, false);
+    }
+}
+
+void I2CBus::invalidate_scan() {
+    I2CBusLock lock(*this);
+    m_seen.clear();
+}
+
+// ---------------------------------------------------------------------
+// Discovery
+// The probe timeout starts at I2C_SCAN_MIN_TMO_MS, so absent addresses cost
+// one address frame each. A timeout doubles it (clock-stretching device) and
+// the address is probed again; the longer timeout is kept for later scans.
+// A bus that still times out at I2C_SCAN_MAX_TMO_MS goes through the
+// recovery ladder once, then the scan gives up.
+// ---------------------------------------------------------------------
+esp_err_t I2CBus::scan(I2CAddrMap *present, const I2CAddrMap *candidates, bool refresh) {
+    if (!present) return ESP_ERR_INVALID_ARG;
+    if (m_status != ESP_OK) return m_status;
+    if (!m_backend->is_open()) return ESP_ERR_INVALID_STATE;
+
+    static const I2CAddrMap s_default = I2CAddrMap::range(0x08, 0x77);
+    const I2CAddrMap &cand = candidates ? *candidates : s_default;
+    if (m_scan_tmo_ms < I2C_SCAN_MIN_TMO_MS) m_scan_tmo_ms = I2C_SCAN_MIN_TMO_MS;
+
+    int64_t t0 = esp_timer_get_time();
+    int probed = 0;
+    bool recovered = false;
+    present->clear();
+
+    for (uint8_t a = 0; a < I2C_ADDR_SLOTS; a++) {
+        if (!cand.test(a)) continue;
+        if (!refresh && m_seen.test(a)) {
+            present->set(a, m_present.test(a));
+            continue;
+        }
+
+        // Lock per address: a scan never holds the bus for more than one probe
+        I2CBusLock lock(*this);
+        if (lock.status() != ESP_OK) return lock.status();
+        esp_err_t err;
+        while (1) {
+            err = m_backend->probe(a, (int)m_scan_tmo_ms);
+            probed++;
+            if (err != ESP_ERR_TIMEOUT) break;
+            if (m_scan_tmo_ms < I2C_SCAN_MAX_TMO_MS) {
+                m_scan_tmo_ms = m_scan_tmo_ms * 2 > I2C_SCAN_MAX_TMO_MS ? I2C_SCAN_MAX_TMO_MS
+                                                                        : m_scan_tmo_ms * 2;
+                continue;
+            }
+            if (recovered || recover_ladder(a) != ESP_OK) {
+                ESP_LOGE(TAG, "scan aborted at 0x%02X: bus not responding", a);
+                return ESP_ERR_TIMEOUT;
+            }
+            recovered = true;
+        }
+        note_presence(a, err);
+        present->set(a, err == ESP_OK);
+    }
+
+    ESP_LOGD(TAG, "scan: %u present, %d probes, %lu us (timeout %lu ms)", (unsigned)present->count(),
+             probed, (unsigned long)(esp_timer_get_time() - t0), (unsigned long)m_scan_tmo_ms);
+    return ESP_OK;
+}
@@ -0,0 +1,238 @@
+#include "ED_i2c_sched.h"
+#include "esp_log.h"
+
+static const char *TAG = "ed_i2c_sched";
+
+#define I2C_SCHED_TASK_STACK_SIZE   3072
+#define I2C_SCHED_CALL_OVERHEAD_US  40     // driver and task cost per transaction, for the load estimate
+
+I2CScheduler::I2CScheduler(I2CBus &bus)
+    : m_bus(bus), m_jobs(), m_count(0), m_load_permille(0), m_stats(),
+      m_timer(nullptr), m_task(nullptr), m_task_exit(nullptr) {}
+
+I2CScheduler::~I2CScheduler() {
+    stop();
+}
+
+// ---------------------------------------------------------------------
+// Jobs
+// ---------------------------------------------------------------------
+
+// Register read: address + register, repeated START, address + data, 9 clocks a byte
+uint32_t I2CScheduler::wire_us(uint8_t len, uint32_t freq) {
+    uint64_t bits = (uint64_t)(len + 3) * 9 + 3;
+    return (uint32_t)(bits * 1000000ULL / (freq ? freq : 100000)) + I2C_SCHED_CALL_OVERHEAD_US;
+}
+
+esp_err_t I2CScheduler::add_job(const I2CSchedJob &job, int *id) {
+    if (job.addr >= I2C_ADDR_SLOTS || job.len == 0 || job.len > I2C_SCHED_MAX_READ || job.period_us == 0)
+        return ESP_ERR_INVALID_ARG;
+    if (m_task) return ESP_ERR_INVALID_STATE;   // jobs are fixed while running
+    if (m_count >= I2C_SCHED_MAX_JOBS) return ESP_ERR_NO_MEM;
+
+    uint32_t load = m_load_permille + (uint32_t)((uint64_t)wire_us(job.len, m_bus.freq()) * 1000 / job.period_us);
+    if (load > I2C_SCHED_MAX_LOAD_PERMILLE) {
+        ESP_LOGW(TAG, "0x%02X every %lu us: bus load would reach %lu/1000", job.addr,
+                 (unsigned long)job.period_us, (unsigned long)load);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    Job &j = m_jobs[m_count];
+    j.cfg = job;
+    j.stats = {};
+    m_load_permille = load;
+    if (id) *id = m_count;
+    m_count++;
+    return ESP_OK;
+}
+
+// ---------------------------------------------------------------------
+// Slots
+// ---------------------------------------------------------------------
+int64_t I2CScheduler::next_wake() const {
+    int64_t wake = INT64_MAX;
+    for (int i = 0; i < m_count; i++) {
+        if (m_jobs[i].due_us < wake) wake = m_jobs[i].due_us;
+    }
+    return wake;
+}
+
+void I2CScheduler::run_slot(int64_t now) {
+    // Every job whose window is open: the merging jobs first, then the
+    // others, each part sorted by device and register so that
+    // transfer_batch() can merge contiguous registers of the first part
+    uint8_t idx[I2C_SCHED_MAX_JOBS];
+    size_t n = 0, merging = 0;
+    for (int i = 0; i < m_count; i++) {
+        const Job &j = m_jobs[i];
+        if (j.due_us - (int64_t)j.cfg.jitter_us > now) continue;
+        size_t k = n++;
+        for (; k > 0; k--) {
+            const I2CSchedJob &prev = m_jobs[idx[k - 1]].cfg;
+            if (prev.merge != j.cfg.merge) {
+                if (prev.merge) break;
+            } else if (prev.addr < j.cfg.addr || (prev.addr == j.cfg.addr && prev.reg <= j.cfg.reg)) {
+                break;
+            }
+            idx[k] = idx[k - 1];
+        }
+        idx[k] = (uint8_t)i;
+        if (j.cfg.merge) merging++;
+    }
+    if (n == 0) return;
+
+    I2CRegOp ops[I2C_SCHED_MAX_JOBS];
+    for (size_t k = 0; k < n; k++) {
+        Job &j = m_jobs[idx[k]];
+        ops[k] = {I2CRegOp::Dir::READ, j.cfg.addr, j.cfg.reg, j.data, j.cfg.len, ESP_ERR_NOT_FINISHED};
+    }
+
+    // One bus session: a device that fails, is quarantined or a lock timeout
+    // leaves its error in the items it covers, and the rest of the slot still runs
+    int64_t t0 = esp_timer_get_time();
+    {
+        I2CBusLock lock(m_bus);
+        if (lock.status() != ESP_OK) {
+            for (size_t k = 0; k < n; k++) ops[k].status = lock.status();
+        } else {
+            if (merging) m_bus.transfer_batch(ops, merging, true);
+            if (merging < n) m_bus.transfer_batch(ops + merging, n - merging, false);
+        }
+    }
+    int64_t t1 = esp_timer_get_time();
+
+    for (size_t k = 0; k < n; k++) {
+        Job &j = m_jobs[idx[k]];
+        int64_t late = t0 - j.due_us;
+        if (late > (int64_t)j.stats.max_late_us) j.stats.max_late_us = (uint32_t)late;
+        if (late > (int64_t)j.cfg.jitter_us) j.stats.late++;
+        j.stats.runs++;
+        if (ops[k].status != ESP_OK) j.stats.errors++;
+        if (j.cfg.cb) j.cfg.cb(j.data, j.cfg.len, ops[k].status, t0, j.cfg.cb_arg);
+    }
+
+    // Next period; whole periods that can no longer start in time are skipped
+    int64_t end = esp_timer_get_time();
+    for (size_t k = 0; k < n; k++) {
+        Job &j = m_jobs[idx[k]];
+        j.due_us += j.cfg.period_us;
+        int64_t behind = end - (j.due_us + (int64_t)j.cfg.jitter_us);
+        if (behind > 0) {
+            uint32_t missed = (uint32_t)(behind / j.cfg.period_us) + 1;
+            j.due_us += (int64_t)missed * j.cfg.period_us;
+            j.stats.skipped += missed;
+        }
+    }
+
+    uint32_t slot_us = (uint32_t)(t1 - t0);
+    m_stats.slots++;
+    m_stats.jobs += n;
+    m_stats.coalesced += n - 1;
+    m_stats.busy_us += slot_us;
+    if (slot_us > m_stats.max_slot_us) m_stats.max_slot_us = slot_us;
+    for (int i = 0; i < m_count; i++) {
+        if (m_jobs[i].due_us + (int64_t)m_jobs[i].cfg.jitter_us < t1) {
+            m_stats.overruns++;
+            break;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------
+// Scheduler task
+// ---------------------------------------------------------------------
+void I2CScheduler::timer_cb(void *arg) {
+    I2CScheduler *s = static_cast<I2CScheduler *>(arg);
+    xTaskNotify(s->m_task, WAKE_BIT, eSetBits);
+}
+
+void I2CScheduler::task(void *arg) {
+    I2CScheduler *s = static_cast<I2CScheduler *>(arg);
+    while (1) {
+        int64_t now = esp_timer_get_time();
+        int64_t wait_us = s->next_wake() - now;
+        if (wait_us > 0) esp_timer_start_once(s->m_timer, (uint64_t)wait_us);
+
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, wait_us > 0 ? portMAX_DELAY : 0);
+        if (bits & STOP_BIT) break;
+        if (wait_us > 0) continue;   // woken by the timer: take a fresh timestamp
+        s->run_slot(now);
+    }
+    esp_timer_stop(s->m_timer);
+    xSemaphoreGive(s->m_task_exit);
+    vTaskDelete(nullptr);
+}
+
+esp_err_t I2CScheduler::start(UBaseType_t priority, BaseType_t core) {
+    if (m_task) return ESP_ERR_INVALID_STATE;
+    if (m_count == 0) return ESP_ERR_INVALID_STATE;
+
+    esp_timer_create_args_t targs = {};
+    targs.callback = timer_cb;
+    targs.arg = this;
+    targs.dispatch_method = ESP_TIMER_TASK;
+    targs.name = "i2c_sched";
+    esp_err_t err = esp_timer_create(&targs, &m_timer);
+    if (err != ESP_OK) return err;
+
+    m_task_exit = xSemaphoreCreateBinary();
+    if (!m_task_exit) {
+        esp_timer_delete(m_timer);
+        m_timer = nullptr;
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Common phase: jobs with harmonic periods fall due in the same slot
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < m_count; i++) m_jobs[i].due_us = t0;
+
+    if (xTaskCreatePinnedToCore(task, "i2c_sched", I2C_SCHED_TASK_STACK_SIZE, this, priority,
+                                &m_task, core) != pdPASS) {
+        vSemaphoreDelete(m_task_exit);
+        esp_timer_delete(m_timer);
+        m_task_exit = nullptr;
+        m_timer = nullptr;
+        m_task = nullptr;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "%d jobs, estimated bus load %lu/1000", m_count, (unsigned long)m_load_permille);
+    return ESP_OK;
+}
+
+void I2CScheduler::stop() {
+    if (!m_task) return;
+    xTaskNotify(m_task, STOP_BIT, eSetBits);
+    xSemaphoreTake(m_task_exit, portMAX_DELAY);
+    vSemaphoreDelete(m_task_exit);
+    esp_timer_delete(m_timer);
+    m_task_exit = nullptr;
+    m_timer = nullptr;
+    m_task = nullptr;
+}
+
+// ---------------------------------------------------------------------
+// Stats
+// ---------------------------------------------------------------------
+esp_err_t I2CScheduler::get_job_stats(int id, I2CSchedJobStats *out) const {
+    if (id < 0 || id >= m_count || !out) return ESP_ERR_INVALID_ARG;
+    *out = m_jobs[id].stats;
+    return ESP_OK;
+}
+
+void I2CScheduler::get_stats(I2CSchedStats *out) const {
+    if (out) *out = m_stats;
+}
+
+void I2CScheduler::log_stats() const {
+    ESP_LOGI(TAG, "%lu slots, %lu reads (%lu coalesced), %lu overruns, longest slot %lu us",
+             (unsigned long)m_stats.slots, (unsigned long)m_stats.jobs, (unsigned long)m_stats.coalesced,
+             (unsigned long)m_stats.overruns, (unsigned long)m_stats.max_slot_us);
+    for (int i = 0; i < m_count; i++) {
+        const Job &j = m_jobs[i];
+        ESP_LOGI(TAG, "  job %d 0x%02X/0x%02X every %lu us: %lu runs, %lu errors, %lu late, %lu skipped, "
+                 "max lateness %lu us", i, j.cfg.addr, j.cfg.reg, (unsigned long)j.cfg.period_us,
+                 (unsigned long)j.stats.runs, (unsigned long)j.stats.errors, (unsigned long)j.stats.late,
+                 (unsigned long)j.stats.skipped, (unsigned long)j.stats.max_late_us);
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef ED_I2C_SCHED_H
+#define ED_I2C_SCHED_H
+
+#include "ED_i2c.h"
+#include "esp_timer.h"
+
+#define I2C_SCHED_MAX_JOBS   16
+#define I2C_SCHED_MAX_READ   32    // bytes per job, one auto-increment burst
+#define I2C_SCHED_MAX_LOAD_PERMILLE  800   // admission limit for the estimated bus load
+
+/// Runs in the scheduler task after each read. Keep it short: it delays the next slot.
+typedef void (*i2c_sched_cb_t)(const uint8_t *data, size_t len, esp_err_t err,
+                               int64_t timestamp_us, void *arg);
+
+/// A periodic register read
+struct I2CSchedJob {
+    uint8_t        addr;
+    uint8_t        reg;          // first register
+    uint8_t        len;          // up to I2C_SCHED_MAX_READ
+    uint32_t       period_us;
+    uint32_t       jitter_us;    // the read may start this much before or after its due time
+    i2c_sched_cb_t cb;
+    void          *cb_arg;
+    bool           merge;        // may share a burst with contiguous registers of other merging
+                                 // jobs of the device; only for byte-addressed auto-increment
+};
+
+struct I2CSchedJobStats {
+    uint32_t runs;
+    uint32_t errors;
+    uint32_t late;          // started more than jitter_us after the due time
+    uint32_t skipped;       // periods dropped because the job was too late to catch up
+    uint32_t max_late_us;
+};
+
+struct I2CSchedStats {
+    uint32_t slots;         // bus sessions run
+    uint32_t jobs;          // reads run
+    uint32_t coalesced;     // reads that shared a slot with another read
+    uint32_t overruns;      // slots that ended after another job's latest start
+    uint32_t max_slot_us;
+    uint64_t busy_us;       // time spent inside slots
+};
+
+/**
+ * @brief Multi-rate sampling on one I2CBus from a single task.
+ *
+ * Devices register periodic reads instead of running a polling task each.
+ * All periods start at the same instant, so jobs with harmonic periods fall
+ * due together. When the earliest job is due, every job whose jitter window
+ * is already open joins the same slot: the reads are sorted by device and
+ * register and run back-to-back through transfer_batch() under one bus lock.
+ * Contiguous registers of a device are merged into one burst only between
+ * jobs that set `merge`; the others are read on their own.
+ *
+ * A slot that takes so long that another job can no longer start within its
+ * jitter counts as an overrun; a job that misses whole periods skips them
+ * rather than running a burst of catch-up reads.
+ */
+class I2CScheduler {
+public:
+    explicit I2CScheduler(I2CBus &bus);
+    ~I2CScheduler();
+    I2CScheduler(const I2CScheduler &) = delete;
+    I2CScheduler &operator=(const I2CScheduler &) = delete;
+
+    // Jobs are added while stopped. ESP_ERR_INVALID_SIZE if the estimated
+    // bus load of all jobs would exceed I2C_SCHED_MAX_LOAD_PERMILLE.
+    esp_err_t add_job(const I2CSchedJob &job, int *id);
+
+    esp_err_t start(UBaseType_t priority = 12, BaseType_t core = tskNO_AFFINITY);
+    void      stop();
+
+    // Estimated share of bus time used by the registered jobs, in 1/1000
+    uint32_t  load_permille() const { return m_load_permille; }
+
+    esp_err_t get_job_stats(int id, I2CSchedJobStats *out) const;
+    void      get_stats(I2CSchedStats *out) const;
+    void      log_stats() const;
+
+private:
+    struct Job {
+        I2CSchedJob      cfg;
+        int64_t          due_us;
+        I2CSchedJobStats stats;
+        uint8_t          data[I2C_SCHED_MAX_READ];
+    };
+
+    static constexpr uint32_t WAKE_BIT = 1u << 0;
+    static constexpr uint32_t STOP_BIT = 1u << 31;
+
+    int64_t     next_wake() const;
+    void        run_slot(int64_t now);
+    static uint32_t wire_us(uint8_t len, uint32_t freq);
+    static void timer_cb(void *arg);
+    static void task(void *arg);
+
+    I2CBus            &m_bus;
+    Job                m_jobs[I2C_SCHED_MAX_JOBS];
+    int                m_count;
+    uint32_t           m_load_permille;
+    I2CSchedStats      m_stats;
+    esp_timer_handle_t m_timer;
+    TaskHandle_t       m_task;
+    SemaphoreHandle_t  m_task_exit;
+};
+
+#endif // ED_I2C_SCHED_H
@@ -0,0 +1,312 @@
+#include "ED_i2c_sim.h"
+#include <cstring>
+
+#define I2C_SIM_DEFAULT_SCL_HZ     100000
+#define I2C_SIM_FOREVER_MS         1000   // what a -1 (wait forever) timeout costs in the model
+#define I2C_SIM_CLEAR_US           110    // bit-banged 9 clocks + STOP
+#define I2C_SIM_PERIPH_RESET_US    100    // module reset and re-enable, as I2CEspBackend waits
+
+namespace {
+struct SimLock {
+    SemaphoreHandle_t h;
+    explicit SimLock(SemaphoreHandle_t lock) : h(lock) { xSemaphoreTake(h, portMAX_DELAY); }
+    ~SimLock() { xSemaphoreGive(h); }
+};
+}
+
+I2CSimBackend::I2CSimBackend()
+    : m_lock(nullptr), m_lock_buf(), m_open(false), m_stuck(false),
+      m_stuck_clear(I2CRecoveryTier::BUS_CLEAR), m_scl_hz(), m_devices(), m_device_used(), m_faults(),
+      m_now_us(0), m_stats()
+{
+    m_lock = xSemaphoreCreateMutexStatic(&m_lock_buf);
+    memset(m_index, NO_DEVICE, sizeof(m_index));
+}
+
+I2CSimBackend::~I2CSimBackend() {
+    vSemaphoreDelete(m_lock);
+}
+
+// ---------------------------------------------------------------------
+// Virtual devices
+// ---------------------------------------------------------------------
+I2CSimDevice *I2CSimBackend::attach(uint8_t addr) {
+    if (addr >= I2C_ADDR_SLOTS) return nullptr;
+    SimLock l(m_lock);
+    if (m_index[addr] != NO_DEVICE) return nullptr;
+    for (uint8_t i = 0; i < I2C_SIM_MAX_DEVICES; i++) {
+        if (m_device_used[i]) continue;
+        I2CSimDevice &d = m_devices[i];
+        memset(&d, 0, sizeof(d));
+        d.addr = addr;
+        m_device_used[i] = true;
+        m_index[addr] = i;
+        return &d;
+    }
+    return nullptr;
+}
+
+void I2CSimBackend::detach(uint8_t addr) {
+    if (addr >= I2C_ADDR_SLOTS) return;
+    SimLock l(m_lock);
+    if (m_index[addr] == NO_DEVICE) return;
+    m_device_used[m_index[addr]] = false;
+    m_index[addr] = NO_DEVICE;
+}
+
+I2CSimDevice *I2CSimBackend::device(uint8_t addr) {
+    if (addr >= I2C_ADDR_SLOTS) return nullptr;
+    SimLock l(m_lock);
+    return m_index[addr] == NO_DEVICE ? nullptr : &m_devices[m_index[addr]];
+}
+
+// ---------------------------------------------------------------------
+// Faults
+// ---------------------------------------------------------------------
+esp_err_t I2CSimBackend::inject(const I2CSimFault &fault) {
+    if (fault.addr != I2C_SIM_ANY_ADDR && fault.addr >= I2C_ADDR_SLOTS) return ESP_ERR_INVALID_ARG;
+    SimLock l(m_lock);
+    for (ActiveFault &f : m_faults) {
+        if (f.used) continue;
+        f.fault = fault;
+        f.used = true;
+        return ESP_OK;
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void I2CSimBackend::clear_faults() {
+    SimLock l(m_lock);
+    for (ActiveFault &f : m_faults) f.used = false;
+    m_stuck = false;
+}
+
+bool I2CSimBackend::bus_stuck() const {
+    SimLock l(m_lock);
+    return m_stuck;
+}
+
+void I2CSimBackend::unstick(I2CRecoveryTier tier) {
+    if (m_stuck && (int)tier >= (int)m_stuck_clear) m_stuck = false;
+}
+
+// ---------------------------------------------------------------------
+// Clock and stats
+// ---------------------------------------------------------------------
+uint64_t I2CSimBackend::now_us() const {
+    SimLock l(m_lock);
+    return m_now_us;
+}
+
+void I2CSimBackend::get_stats(I2CSimStats *out) const {
+    if (!out) return;
+    SimLock l(m_lock);
+    *out = m_stats;
+}
+
+void I2CSimBackend::reset_stats() {
+    SimLock l(m_lock);
+    m_stats = {};
+}
+
+// Address byte plus `bytes` data bytes, 9 clocks each, plus START and STOP
+void I2CSimBackend::wire_time(uint8_t addr, size_t bytes) {
+    uint32_t hz = m_scl_hz[addr] ? m_scl_hz[addr] : I2C_SIM_DEFAULT_SCL_HZ;
+    uint64_t us = ((uint64_t)(bytes + 1) * 9 + 2) * 1000000ULL / hz;
+    if (m_index[addr] != NO_DEVICE) us += m_devices[m_index[addr]].stretch_us;
+    m_now_us += us;
+    m_stats.bus_time_us += us;
+}
+
+void I2CSimBackend::timeout(int timeout_ms) {
+    uint64_t us = (uint64_t)(timeout_ms < 0 ? I2C_SIM_FOREVER_MS : timeout_ms) * 1000;
+    m_now_us += us;
+    m_stats.bus_time_us += us;
+    m_stats.timeouts++;
+}
+
+// ---------------------------------------------------------------------
+// Transaction start: faults, stuck bus, address phase. Lock held.
+// ---------------------------------------------------------------------
+esp_err_t I2CSimBackend::begin(uint8_t addr, int timeout_ms, bool is_probe, I2CSimDevice **dev) {
+    if (!m_open || addr >= I2C_ADDR_SLOTS) return ESP_ERR_INVALID_STATE;
+    if (!is_probe && !m_scl_hz[addr]) return ESP_ERR_INVALID_STATE;
+    m_stats.transactions++;
+
+    const I2CSimFault *hit = nullptr;
+    for (ActiveFault &f : m_faults) {
+        if (!f.used || (f.fault.addr != I2C_SIM_ANY_ADDR && f.fault.addr != addr)) continue;
+        if (f.fault.skip) {
+            f.fault.skip--;
+            continue;
+        }
+        if (!hit) {
+            hit = &f.fault;
+            if (f.fault.kind == I2CSimFaultKind::STUCK_SDA) {
+                m_stuck = true;
+                m_stuck_clear = f.fault.cleared_by;
+                f.used = false;
+            } else if (f.fault.count && --f.fault.count == 0) {
+                f.used = false;
+            }
+        }
+    }
+
+    if (m_stuck || (hit && hit->kind == I2CSimFaultKind::TIMEOUT)) {
+        timeout(timeout_ms);
+        return ESP_ERR_TIMEOUT;
+    }
+    I2CSimDevice *d = m_index[addr] == NO_DEVICE ? nullptr : &m_devices[m_index[addr]];
+    if (addr == I2C_GENERAL_CALL_ADDR && !is_probe) {
+        // Acknowledged if any device listens to general calls
+        for (uint8_t i = 0; i < I2C_SIM_MAX_DEVICES && !d; i++) {
+            if (m_device_used[i] && m_devices[i].general_call) d = &m_devices[i];
+        }
+    }
+    bool too_fast = d && d->max_scl_hz && m_scl_hz[addr] > d->max_scl_hz;
+    if (!d || too_fast || (hit && hit->kind == I2CSimFaultKind::NACK)) {
+        wire_time(addr, 0);
+        m_stats.nacks++;
+        return is_probe ? ESP_ERR_NOT_FOUND : ESP_ERR_INVALID_STATE;
+    }
+    *dev = d;
+    return ESP_OK;
+}
+
+void I2CSimBackend::write_bytes(I2CSimDevice &dev, const uint8_t *data, size_t len) {
+    if (len == 0) return;
+    write_regs(dev, data[0], data + 1, len - 1);
+}
+
+void I2CSimBackend::write_regs(I2CSimDevice &dev, uint8_t reg, const uint8_t *data, size_t len) {
+    dev.pointer = reg;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t r = dev.pointer++;
+        if (!dev.is_read_only(r)) dev.regs[r] = data[i];
+        if (dev.hook) dev.hook(dev, r, true, dev.hook_arg);
+    }
+}
+
+void I2CSimBackend::read_bytes(I2CSimDevice &dev, uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        uint8_t reg = dev.pointer++;
+        if (dev.hook) dev.hook(dev, reg, false, dev.hook_arg);
+        data[i] = dev.regs[reg];
+    }
+}
+
+// ---------------------------------------------------------------------
+// I2CBackend
+// ---------------------------------------------------------------------
+esp_err_t I2CSimBackend::open() {
+    SimLock l(m_lock);
+    if (!m_open) m_stats.opens++;
+    m_open = true;
+    return ESP_OK;
+}
+
+void I2CSimBackend::close() {
+    SimLock l(m_lock);
+    m_open = false;
+    memset(m_scl_hz, 0, sizeof(m_scl_hz));
+}
+
+esp_err_t I2CSimBackend::add_device(uint8_t addr, uint32_t scl_hz) {
+    if (addr >= I2C_ADDR_SLOTS || scl_hz == 0) return ESP_ERR_INVALID_ARG;
+    SimLock l(m_lock);
+    if (!m_open) return ESP_ERR_INVALID_STATE;
+    m_scl_hz[addr] = scl_hz;
+    return ESP_OK;
+}
+
+void I2CSimBackend::remove_device(uint8_t addr) {
+    if (addr >= I2C_ADDR_SLOTS) return;
+    SimLock l(m_lock);
+    m_scl_hz[addr] = 0;
+}
+
+esp_err_t I2CSimBackend::transmit(uint8_t addr, const uint8_t *data, size_t len, int timeout_ms) {
+    SimLock l(m_lock);
+    I2CSimDevice *dev;
+    esp_err_t err = begin(addr, timeout_ms, false, &dev);
+    if (err != ESP_OK) return err;
+    if (addr == I2C_GENERAL_CALL_ADDR) {
+        for (uint8_t i = 0; i < I2C_SIM_MAX_DEVICES; i++) {
+            I2CSimDevice &d = m_devices[i];
+            if (m_device_used[i] && d.general_call) d.general_call(d, data, len, d.hook_arg);
+        }
+    } else {
+        write_bytes(*dev, data, len);
+    }
+    wire_time(addr, len);
+    return ESP_OK;
+}
+
+esp_err_t I2CSimBackend::transmit_reg(uint8_t addr, uint8_t reg, const uint8_t *data, size_t len,
+                                      int timeout_ms) {
+    if (addr == I2C_GENERAL_CALL_ADDR) return ESP_ERR_NOT_SUPPORTED;   // handlers take one buffer
+    SimLock l(m_lock);
+    I2CSimDevice *dev;
+    esp_err_t err = begin(addr, timeout_ms, false, &dev);
+    if (err != ESP_OK) return err;
+    write_regs(*dev, reg, data, len);
+    wire_time(addr, len + 1);
+    return ESP_OK;
+}
+
+esp_err_t I2CSimBackend::receive(uint8_t addr, uint8_t *data, size_t len, int timeout_ms) {
+    SimLock l(m_lock);
+    I2CSimDevice *dev;
+    esp_err_t err = begin(addr, timeout_ms, false, &dev);
+    if (err != ESP_OK) return err;
+    read_bytes(*dev, data, len);
+    wire_time(addr, len);
+    return ESP_OK;
+}
+
+esp_err_t I2CSimBackend::transmit_receive(uint8_t addr, const uint8_t *wdata, size_t wlen,
+                                          uint8_t *rdata, size_t rlen, int timeout_ms) {
+    SimLock l(m_lock);
+    I2CSimDevice *dev;
+    esp_err_t err = begin(addr, timeout_ms, false, &dev);
+    if (err != ESP_OK) return err;
+    write_bytes(*dev, wdata, wlen);
+    read_bytes(*dev, rdata, rlen);
+    wire_time(addr, wlen + 1 + rlen);   // repeated START re-sends the address
+    return ESP_OK;
+}
+
+esp_err_t I2CSimBackend::probe(uint8_t addr, int timeout_ms) {
+    SimLock l(m_lock);
+    I2CSimDevice *dev;
+    esp_err_t err = begin(addr, timeout_ms, true, &dev);
+    if (err != ESP_OK) return err;
+    wire_time(addr, 0);
+    return ESP_OK;
+}
+
+esp_err_t I2CSimBackend::bus_reset() {
+    SimLock l(m_lock);
+    if (!m_open) return ESP_ERR_INVALID_STATE;
+    m_stats.bus_resets++;
+    m_now_us += I2C_SIM_CLEAR_US;
+    m_stats.bus_time_us += I2C_SIM_CLEAR_US;
+    unstick(I2CRecoveryTier::BUS_CLEAR);
+    return ESP_OK;
+}
+
+void I2CSimBackend::bus_clear() {
+    SimLock l(m_lock);
+    m_stats.bus_clears++;
+    m_now_us += I2C_SIM_CLEAR_US;
+    m_stats.bus_time_us += I2C_SIM_CLEAR_US;
+    unstick(I2CRecoveryTier::DRIVER_REINIT);
+}
+
+void I2CSimBackend::periph_reset() {
+    SimLock l(m_lock);
+    m_stats.periph_resets++;
+    m_now_us += I2C_SIM_PERIPH_RESET_US;
+    m_stats.bus_time_us += I2C_SIM_PERIPH_RESET_US;
+    unstick(I2CRecoveryTier::PERIPH_RESET);
+}
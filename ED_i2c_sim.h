@@ -0,0 +1,145 @@
+#ifndef ED_I2C_SIM_H
+#define ED_I2C_SIM_H
+
+#include "ED_i2c.h"
+
+#define I2C_SIM_MAX_DEVICES   8
+#define I2C_SIM_MAX_FAULTS    8
+#define I2C_SIM_ANY_ADDR      0xFF
+
+struct I2CSimDevice;
+
+/// Called for every register byte moved over the bus, before a read byte is
+/// sent or after a written byte is stored. Runs inside the backend lock: it
+/// may change `dev` but must not call the backend.
+typedef void (*i2c_sim_hook_t)(I2CSimDevice &dev, uint8_t reg, bool write, void *arg);
+
+/// Called with the payload of a general call (address 0x00). Same rules as
+/// the register hook; gets the same `hook_arg`.
+typedef void (*i2c_sim_gc_t)(I2CSimDevice &dev, const uint8_t *data, size_t len, void *arg);
+
+/**
+ * @brief Virtual device: 256 8-bit registers behind an auto-incrementing
+ * register pointer. A write sets the pointer with its first byte and stores
+ * the rest; a read returns bytes from the pointer on.
+ */
+struct I2CSimDevice {
+    uint8_t        addr;
+    uint8_t        regs[256];
+    uint32_t       read_only[8];   // bitmap, bus writes to these registers are dropped
+    uint8_t        pointer;
+    uint32_t       stretch_us;     // clock stretching added to every transfer
+    uint32_t       max_scl_hz;     // faster transfers are not acknowledged, 0 = any speed
+    i2c_sim_hook_t hook;
+    i2c_sim_gc_t   general_call;   // nullptr = general calls are ignored
+    void          *hook_arg;
+
+    void set_read_only(uint8_t first, uint8_t last) {
+        for (unsigned r = first; r <= last; r++) read_only[r >> 5] |= 1u << (r & 31);
+    }
+    bool is_read_only(uint8_t reg) const { return (read_only[reg >> 5] >> (reg & 31)) & 1u; }
+};
+
+enum class I2CSimFaultKind : uint8_t {
+    NACK,        // address not acknowledged
+    TIMEOUT,     // transfer hangs until its timeout
+    STUCK_SDA,   // a slave holds SDA low: every transfer times out until recovery frees the bus
+};
+
+struct I2CSimFault {
+    I2CSimFaultKind kind;
+    uint8_t         addr;         // I2C_SIM_ANY_ADDR = any address
+    uint16_t        skip;         // matching transactions let through first
+    uint16_t        count;        // matching transactions affected, 0 = until clear_faults()
+    I2CRecoveryTier cleared_by;   // STUCK_SDA: cheapest recovery tier that frees the bus
+};
+
+struct I2CSimStats {
+    uint32_t transactions;    // transfers and probes
+    uint32_t nacks;
+    uint32_t timeouts;
+    uint32_t bus_resets;      // BUS_CLEAR tier
+    uint32_t bus_clears;      // bit-banged clears (DRIVER_REINIT and PERIPH_RESET)
+    uint32_t periph_resets;
+    uint32_t opens;
+    uint64_t bus_time_us;     // modelled time on the wire, timeouts and recovery steps included
+};
+
+/**
+ * @brief Simulated I2CBackend for host builds and deterministic benchmarks.
+ *
+ * Nothing here touches hardware. Time is modelled, not measured: every
+ * transaction advances a virtual clock by its length at the device's SCL
+ * speed (plus stretching), and a timeout by the full timeout, so
+ * throughput and recovery cost are reproducible from run to run.
+ */
+class I2CSimBackend : public I2CBackend {
+public:
+    I2CSimBackend();
+    ~I2CSimBackend() override;
+    I2CSimBackend(const I2CSimBackend &) = delete;
+    I2CSimBackend &operator=(const I2CSimBackend &) = delete;
+
+    // Virtual devices (zeroed registers, all writable)
+    I2CSimDevice *attach(uint8_t addr);
+    void          detach(uint8_t addr);
+    I2CSimDevice *device(uint8_t addr);
+
+    // Fault injection
+    esp_err_t inject(const I2CSimFault &fault);
+    void      clear_faults();   // also releases a stuck bus
+    bool      bus_stuck() const;
+
+    uint64_t  now_us() const;
+    void      get_stats(I2CSimStats *out) const;
+    void      reset_stats();
+
+    // I2CBackend
+    esp_err_t open() override;
+    void      close() override;
+    bool      is_open() const override { return m_open; }
+    esp_err_t add_device(uint8_t addr, uint32_t scl_hz) override;
+    void      remove_device(uint8_t addr) override;
+    esp_err_t transmit(uint8_t addr, const uint8_t *data, size_t len, int timeout_ms) override;
+    esp_err_t transmit_reg(uint8_t addr, uint8_t reg, const uint8_t *data, size_t len,
+                           int timeout_ms) override;   // not to the general call address
+    esp_err_t receive(uint8_t addr, uint8_t *data, size_t len, int timeout_ms) override;
+    esp_err_t transmit_receive(uint8_t addr, const uint8_t *wdata, size_t wlen,
+                               uint8_t *rdata, size_t rlen, int timeout_ms) override;
+    esp_err_t probe(uint8_t addr, int timeout_ms) override;
+    esp_err_t bus_reset() override;
+    void      bus_clear() override;
+    void      periph_reset() override;
+
+private:
+    struct ActiveFault {
+        I2CSimFault fault;
+        bool        used;
+    };
+
+    esp_err_t begin(uint8_t addr, int timeout_ms, bool is_probe, I2CSimDevice **dev);
+    void      wire_time(uint8_t addr, size_t bytes);
+    void      timeout(int timeout_ms);
+    void      write_bytes(I2CSimDevice &dev, const uint8_t *data, size_t len);
+    void      write_regs(I2CSimDevice &dev, uint8_t reg, const uint8_t *data, size_t len);
+    void      read_bytes(I2CSimDevice &dev, uint8_t *data, size_t len);
+    void      unstick(I2CRecoveryTier tier);
+
+    SemaphoreHandle_t  m_lock;
+    StaticSemaphore_t  m_lock_buf;
+
+    bool           m_open;
+    bool           m_stuck;
+    I2CRecoveryTier m_stuck_clear;
+    uint32_t       m_scl_hz[I2C_ADDR_SLOTS];   // 0 = no handle
+    I2CSimDevice   m_devices[I2C_SIM_MAX_DEVICES];
+    bool           m_device_used[I2C_SIM_MAX_DEVICES];
+    uint8_t        m_index[I2C_ADDR_SLOTS];    // address -> m_devices slot, NO_DEVICE if none
+    ActiveFault    m_faults[I2C_SIM_MAX_FAULTS];
+    uint64_t       m_now_us;
+    I2CSimStats    m_stats;
+
+    static constexpr uint8_t NO_DEVICE = 0xFF;
+};
+
+#endif // ED_I2C_SIM_H
@@ -0,0 +1,130 @@
+#include "ED_i2c.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "ed_i2c";
+
+// Leaky bucket: an error adds I2C_SPEED_ERR_WEIGHT, a success removes 1, the
+// device steps down at I2C_SPEED_DOWN_SCORE. Two errors back-to-back, or an
+// error rate above one in I2C_SPEED_ERR_WEIGHT transactions, trigger it.
+#define I2C_SPEED_ERR_WEIGHT     4
+#define I2C_SPEED_DOWN_SCORE     8
+#define I2C_SPEED_UP_AFTER_OK    100      // successes at a speed before trying the next faster one
+#define I2C_SPEED_TRIAL_OK       20       // successes that confirm a step up
+#define I2C_SPEED_UP_BASE_MS     5000     // first step-up attempt after a step down
+#define I2C_SPEED_UP_MAX_MS      300000   // cap of the step-up backoff
+
+// Fast-mode Plus needs a controller that supports it; the original ESP32 does not
+#if CONFIG_IDF_TARGET_ESP32
+#define I2C_SPEED_CHIP_MAX_HZ    400000
+#else
+#define I2C_SPEED_CHIP_MAX_HZ    1000000
+#endif
+
+static const uint32_t speed_ladder[] = {1000000, 400000, 100000};
+static constexpr uint8_t SPEED_STEPS = sizeof(speed_ladder) / sizeof(speed_ladder[0]);
+
+esp_err_t I2CBus::enable_adaptive_speed(uint32_t max_hz) {
+    if (max_hz == 0 || max_hz > I2C_SPEED_CHIP_MAX_HZ) max_hz = I2C_SPEED_CHIP_MAX_HZ;
+    uint8_t top = 0;
+    while (top + 1 < SPEED_STEPS && speed_ladder[top] > max_hz) top++;
+
+    I2CBusLock lock(*this);
+    if (lock.status() != ESP_OK) return lock.status();
+    m_top_speed = top;
+    m_adaptive = true;
+    for (uint8_t a = 0; a < I2C_ADDR_SLOTS; a++) {
+        DeviceSlot &s = m_slots[a];
+        if (s.attached) {
+            m_backend->remove_device(a);   // re-added at its new speed on next use
+            s.attached = false;
+        }
+        s.speed = top;
+        s.speed_score = 0;
+        s.speed_trial = false;
+        s.speed_ok = 0;
+        s.speed_backoff_ms = 0;
+        s.speed_next_up_us = 0;
+    }
+    ESP_LOGI(TAG, "port %d: adaptive SCL speed, devices start at %lu kHz", (int)m_port,
+             (unsigned long)(speed_ladder[top] / 1000));
+    return ESP_OK;
+}
+
+uint32_t I2CBus::device_hz(const DeviceSlot &slot) const {
+    return m_adaptive ? speed_ladder[slot.speed] : m_freq;
+}
+
+uint32_t I2CBus::device_speed(uint8_t addr) const {
+    return addr < I2C_ADDR_SLOTS ? device_hz(m_slots[addr]) : 0;
+}
+
+void I2CBus::report_crc_error(uint8_t addr) {
+    if (!m_adaptive || addr >= I2C_ADDR_SLOTS) return;
+    I2CBusLock lock(*this);
+    if (lock.status() == ESP_OK) adapt_speed(addr, ESP_ERR_INVALID_CRC);
+}
+
+// The backend device is dropped; get_device() adds it back at the new speed
+void I2CBus::set_speed(uint8_t addr, uint8_t speed) {
+    DeviceSlot &s = m_slots[addr];
+    if (s.attached) {
+        m_backend->remove_device(addr);
+        s.attached = false;
+    }
+    s.speed = speed;
+    s.speed_score = 0;
+    s.speed_ok = 0;
+}
+
+// ---------------------------------------------------------------------
+// Called after every attempt (run_retry()) while adaptive speed is on
+// ---------------------------------------------------------------------
+void I2CBus::adapt_speed(uint8_t addr, esp_err_t err) {
+    if (err == ESP_ERR_INVALID_ARG) return;   // caller error, not the wire
+    DeviceSlot &s = m_slots[addr];
+    int64_t now = esp_timer_get_time();
+
+    if (err == ESP_OK) {
+        if (s.speed_score) s.speed_score--;
+        if (s.speed_ok < UINT16_MAX) s.speed_ok++;
+        if (s.speed_trial) {
+            if (s.speed_ok >= I2C_SPEED_TRIAL_OK) {
+                s.speed_trial = false;
+                s.speed_backoff_ms = 0;
+                ESP_LOGI(TAG, "0x%02X: holds %lu kHz", addr, (unsigned long)(device_hz(s) / 1000));
+            }
+            return;
+        }
+        if (s.speed > m_top_speed && s.speed_ok >= I2C_SPEED_UP_AFTER_OK && now >= s.speed_next_up_us) {
+            set_speed(addr, s.speed - 1);
+            s.speed_trial = true;
+            ESP_LOGI(TAG, "0x%02X: trying %lu kHz", addr, (unsigned long)(device_hz(s) / 1000));
+        }
+        return;
+    }
+
+    if (s.speed_trial) {
+        // The faster step failed again: back down, and wait longer next time
+        uint32_t backoff = s.speed_backoff_ms ? s.speed_backoff_ms * 2 : I2C_SPEED_UP_BASE_MS;
+        s.speed_backoff_ms = backoff > I2C_SPEED_UP_MAX_MS ? I2C_SPEED_UP_MAX_MS : backoff;
+        s.speed_next_up_us = now + (int64_t)s.speed_backoff_ms * 1000;
+        s.speed_trial = false;
+        set_speed(addr, s.speed + 1);
+        ESP_LOGW(TAG, "0x%02X: %s on step up, back to %lu kHz, next try in %lu ms", addr,
+                 esp_err_to_name(err), (unsigned long)(device_hz(s) / 1000), (unsigned long)s.speed_backoff_ms);
+        return;
+    }
+
+    s.speed_score += I2C_SPEED_ERR_WEIGHT;
+    if (s.speed_score < I2C_SPEED_DOWN_SCORE || s.speed + 1 >= SPEED_STEPS) {
+        if (s.speed_score > I2C_SPEED_DOWN_SCORE) s.speed_score = I2C_SPEED_DOWN_SCORE;
+        return;
+    }
+    if (!s.speed_backoff_ms) s.speed_backoff_ms = I2C_SPEED_UP_BASE_MS;
+    s.speed_next_up_us = now + (int64_t)s.speed_backoff_ms * 1000;
+    uint32_t from = device_hz(s);
+    set_speed(addr, s.speed + 1);
+    ESP_LOGW(TAG, "0x%02X: %s at %lu kHz, stepping down to %lu kHz", addr, esp_err_to_name(err),
+             (unsigned long)(from / 1000), (unsigned long)(device_hz(s) / 1000));
+}
@@ -0,0 +1,396 @@
+#include "ED_i2c_trace.h"
+#include "ED_i2c_sim.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <cstring>
+
+static const char *TAG = "ed_i2c";
+
+#define I2C_TRACE_REPLAY_MAX_LEN   256   // longest transfer replayed, longer ones are cut
+
+I2CTrace::I2CTrace(I2CTraceRecord *buf, size_t capacity)
+    : m_buf(buf), m_mask(0), m_inner(nullptr), m_head(0), m_base(0), m_dropped(0), m_paused(false)
+{
+    size_t cap = 1;
+    while (cap * 2 <= capacity) cap *= 2;
+    m_mask = buf && capacity ? (uint32_t)(cap - 1) : 0;
+    if (!buf || !capacity) m_paused = true;   // nowhere to record
+}
+
+const char *I2CTrace::op_name(I2CTraceOp op) {
+    switch (op) {
+    case I2CTraceOp::TRANSMIT:         return "write";
+    case I2CTraceOp::RECEIVE:          return "read";
+    case I2CTraceOp::TRANSMIT_RECEIVE: return "write_read";
+    case I2CTraceOp::PROBE:            return "probe";
+    case I2CTraceOp::ADD_DEVICE:       return "add_device";
+    case I2CTraceOp::REMOVE_DEVICE:    return "remove_device";
+    case I2CTraceOp::OPEN:             return "open";
+    case I2CTraceOp::CLOSE:            return "close";
+    case I2CTraceOp::BUS_RESET:        return "bus_reset";
+    case I2CTraceOp::BUS_CLEAR:        return "bus_clear";
+    case I2CTraceOp::PERIPH_RESET:     return "periph_reset";
+    case I2CTraceOp::RETRY:            return "RETRY";
+    case I2CTraceOp::RECOVERY:         return "RECOVERY";
+    case I2CTraceOp::BREAKER_TRIP:     return "BREAKER_TRIP";
+    }
+    return "?";
+}
+
+// ---------------------------------------------------------------------
+// Recording (bus lock held: one writer at a time)
+// ---------------------------------------------------------------------
+void I2CTrace::record(I2CTraceOp op, uint8_t addr, int64_t t0, esp_err_t err,
+                      const uint8_t *wdata, size_t wlen, const uint8_t *rdata, size_t rlen) {
+    int64_t now = esp_timer_get_time();
+    if (m_paused.load(std::memory_order_acquire)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint32_t h = m_head.load(std::memory_order_relaxed);
+    I2CTraceRecord &r = m_buf[h & m_mask];
+    r.ts_us = t0;
+    r.dur_us = (uint32_t)(now - t0);
+    r.err = err;
+    r.wlen = (uint16_t)(wlen > UINT16_MAX ? UINT16_MAX : wlen);
+    r.rlen = (uint16_t)(rlen > UINT16_MAX ? UINT16_MAX : rlen);
+    r.op = op;
+    r.addr = addr;
+    size_t nw = wdata ? (wlen < I2C_TRACE_DATA_BYTES ? wlen : I2C_TRACE_DATA_BYTES) : 0;
+    size_t nr = rdata && err == ESP_OK ? (rlen < I2C_TRACE_DATA_BYTES ? rlen : I2C_TRACE_DATA_BYTES) : 0;
+    memset(r.wdata, 0, sizeof(r.wdata));
+    memset(r.rdata, 0, sizeof(r.rdata));
+    if (nw) memcpy(r.wdata, wdata, nw);
+    if (nr) memcpy(r.rdata, rdata, nr);
+    m_head.store(h + 1, std::memory_order_release);
+}
+
+void I2CTrace::event(I2CTraceOp op, uint8_t addr, esp_err_t err, uint16_t arg, uint32_t dur_us) {
+    record(op, addr, esp_timer_get_time() - dur_us, err, nullptr, arg, nullptr, 0);
+}
+
+esp_err_t I2CTrace::open() {
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = m_inner->open();
+    record(I2CTraceOp::OPEN, 0, t0, err, nullptr, 0, nullptr, 0);
+    return err;
+}
+
+void I2CTrace::close() {
+    int64_t t0 = esp_timer_get_time();
+    m_inner->close();
+    record(I2CTraceOp::CLOSE, 0, t0, ESP_OK, nullptr, 0, nullptr, 0);
+}
+
+esp_err_t I2CTrace::add_device(uint8_t addr, uint32_t scl_hz) {
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = m_inner->add_device(addr, scl_hz);
+    record(I2CTraceOp::ADD_DEVICE, addr, t0, err, nullptr, scl_hz / 1000, nullptr, 0);
+    return err;
+}
+
+void I2CTrace::remove_device(uint8_t addr) {
+    int64_t t0 = esp_timer_get_time();
+    m_inner->remove_device(addr);
+    record(I2CTraceOp::REMOVE_DEVICE, addr, t0, ESP_OK, nullptr, 0, nullptr, 0);
+}
+
+esp_err_t I2CTrace::transmit(uint8_t addr, const uint8_t *data, size_t len, int timeout_ms) {
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = m_inner->transmit(addr, data, len, timeout_ms);
+    record(I2CTraceOp::TRANSMIT, addr, t0, err, data, len, nullptr, 0);
+    return err;
+}
+
+// Recorded as the plain write it is on the wire, register byte first
+esp_err_t I2CTrace::transmit_reg(uint8_t addr, uint8_t reg, const uint8_t *data, size_t len,
+                                 int timeout_ms) {
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = m_inner->transmit_reg(addr, reg, data, len, timeout_ms);
+    uint8_t head[I2C_TRACE_DATA_BYTES] = {reg};
+    memcpy(head + 1, data, len < sizeof(head) - 1 ? len : sizeof(head) - 1);
+    record(I2CTraceOp::TRANSMIT, addr, t0, err, head, len + 1, nullptr, 0);
+    return err;
+}
+
+esp_err_t I2CTrace::receive(uint8_t addr, uint8_t *data, size_t len, int timeout_ms) {
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = m_inner->receive(addr, data, len, timeout_ms);
+    record(I2CTraceOp::RECEIVE, addr, t0, err, nullptr, 0, data, len);
+    return err;
+}
+
+esp_err_t I2CTrace::transmit_receive(uint8_t addr, const uint8_t *wdata, size_t wlen,
+                                     uint8_t *rdata, size_t rlen, int timeout_ms) {
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = m_inner->transmit_receive(addr, wdata, wlen, rdata, rlen, timeout_ms);
+    record(I2CTraceOp::TRANSMIT_RECEIVE, addr, t0, err, wdata, wlen, rdata, rlen);
+    return err;
+}
+
+esp_err_t I2CTrace::probe(uint8_t addr, int timeout_ms) {
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = m_inner->probe(addr, timeout_ms);
+    record(I2CTraceOp::PROBE, addr, t0, err, nullptr, 0, nullptr, 0);
+    return err;
+}
+
+esp_err_t I2CTrace::bus_reset() {
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = m_inner->bus_reset();
+    record(I2CTraceOp::BUS_RESET, 0, t0, err, nullptr, 0, nullptr, 0);
+    return err;
+}
+
+void I2CTrace::bus_clear() {
+    int64_t t0 = esp_timer_get_time();
+    m_inner->bus_clear();
+    record(I2CTraceOp::BUS_CLEAR, 0, t0, ESP_OK, nullptr, 0, nullptr, 0);
+}
+
+void I2CTrace::periph_reset() {
+    int64_t t0 = esp_timer_get_time();
+    m_inner->periph_reset();
+    record(I2CTraceOp::PERIPH_RESET, 0, t0, ESP_OK, nullptr, 0, nullptr, 0);
+}
+
+// ---------------------------------------------------------------------
+// Readers. Pausing stops new records; one already being written when the
+// pause starts lands in the slot of index `head`, so when the ring is full
+// the oldest record is left out.
+// ---------------------------------------------------------------------
+bool I2CTrace::pause() {
+    return !m_paused.exchange(true, std::memory_order_acq_rel);
+}
+
+void I2CTrace::window(uint32_t *first, uint32_t *end) const {
+    uint32_t head = m_head.load(std::memory_order_acquire);
+    uint32_t base = m_base.load(std::memory_order_relaxed);
+    uint32_t cap = m_mask + 1;
+    *first = head - base >= cap ? head - cap + 1 : base;
+    *end = head;
+}
+
+size_t I2CTrace::snapshot(I2CTraceRecord *out, size_t max, uint32_t *lost) {
+    if (!out || !pause()) return 0;
+    uint32_t first, end;
+    window(&first, &end);
+    if (end - first > max) first = end - (uint32_t)max;
+    size_t n = 0;
+    for (uint32_t i = first; i != end; i++) out[n++] = m_buf[i & m_mask];
+    if (lost) *lost = first - m_base.load(std::memory_order_relaxed) + m_dropped.load(std::memory_order_relaxed);
+    resume();
+    return n;
+}
+
+esp_err_t I2CTrace::dump(i2c_trace_sink_t sink, void *arg) {
+    if (!sink) return ESP_ERR_INVALID_ARG;
+    if (!m_buf) return ESP_ERR_INVALID_STATE;
+    if (!pause()) return ESP_ERR_INVALID_STATE;   // another reader
+    uint32_t first, end;
+    window(&first, &end);
+    I2CTraceHeader hdr = {};
+    hdr.magic = I2C_TRACE_MAGIC;
+    hdr.version = I2C_TRACE_VERSION;
+    hdr.record_size = sizeof(I2CTraceRecord);
+    hdr.count = end - first;
+    hdr.lost = first - m_base.load(std::memory_order_relaxed) + m_dropped.load(std::memory_order_relaxed);
+    esp_err_t err = sink(&hdr, sizeof(hdr), arg);
+
+    // Straight from the ring: at most two contiguous pieces
+    uint32_t i = first;
+    while (err == ESP_OK && i != end) {
+        uint32_t slot = i & m_mask;
+        uint32_t n = end - i;
+        if (n > m_mask + 1 - slot) n = m_mask + 1 - slot;
+        err = sink(&m_buf[slot], n * sizeof(I2CTraceRecord), arg);
+        i += n;
+    }
+    resume();
+    return err;
+}
+
+static void hex_bytes(char *out, const uint8_t *data, size_t len) {
+    size_t n = len < I2C_TRACE_DATA_BYTES ? len : I2C_TRACE_DATA_BYTES;
+    char *p = out;
+    for (size_t i = 0; i < n; i++) p += sprintf(p, i ? " %02X" : "%02X", data[i]);
+    if (len > n) strcpy(p, " ..");
+    else *p = '\0';
+}
+
+void I2CTrace::log(size_t last) {
+    if (!m_buf || !pause()) return;
+    uint32_t first, end;
+    window(&first, &end);
+    if (last && end - first > last) first = end - (uint32_t)last;
+    ESP_LOGI(TAG, "trace: %lu records, showing %lu", (unsigned long)(end - m_base.load(std::memory_order_relaxed)),
+             (unsigned long)(end - first));
+
+    int64_t t_ref = first != end ? m_buf[first & m_mask].ts_us : 0;
+    for (uint32_t i = first; i != end; i++) {
+        const I2CTraceRecord &r = m_buf[i & m_mask];
+        long long rel = (long long)(r.ts_us - t_ref);
+        char w[16], rd[16];
+        switch (r.op) {
+        case I2CTraceOp::TRANSMIT:
+        case I2CTraceOp::RECEIVE:
+        case I2CTraceOp::TRANSMIT_RECEIVE:
+            hex_bytes(w, r.wdata, r.wlen);
+            hex_bytes(rd, r.rdata, r.err == ESP_OK ? r.rlen : 0);
+            ESP_LOGI(TAG, "%9lld us 0x%02X %-10s w%u [%s] r%u [%s] %lu us %s", rel, r.addr, op_name(r.op),
+                     (unsigned)r.wlen, w, (unsigned)r.rlen, rd, (unsigned long)r.dur_us, esp_err_to_name(r.err));
+            break;
+        case I2CTraceOp::PROBE:
+        case I2CTraceOp::REMOVE_DEVICE:
+        case I2CTraceOp::BREAKER_TRIP:
+            ESP_LOGI(TAG, "%9lld us 0x%02X %-10s %lu us %s", rel, r.addr, op_name(r.op),
+                     (unsigned long)r.dur_us, esp_err_to_name(r.err));
+            break;
+        case I2CTraceOp::ADD_DEVICE:
+            ESP_LOGI(TAG, "%9lld us 0x%02X %-10s %u kHz %s", rel, r.addr, op_name(r.op), (unsigned)r.wlen,
+                     esp_err_to_name(r.err));
+            break;
+        case I2CTraceOp::RETRY:
+            ESP_LOGI(TAG, "%9lld us 0x%02X %-10s attempt %u failed: %s", rel, r.addr, op_name(r.op),
+                     (unsigned)r.wlen, esp_err_to_name(r.err));
+            break;
+        case I2CTraceOp::RECOVERY:
+            ESP_LOGI(TAG, "%9lld us 0x%02X %-10s tier %u, %lu us, %s", rel, r.addr, op_name(r.op),
+                     (unsigned)r.wlen, (unsigned long)r.dur_us, r.err == ESP_OK ? "bus answers" : "no answer");
+            break;
+        default:
+            ESP_LOGI(TAG, "%9lld us      %-10s %lu us %s", rel, op_name(r.op), (unsigned long)r.dur_us,
+                     esp_err_to_name(r.err));
+            break;
+        }
+    }
+    resume();
+}
+
+void I2CTrace::clear() {
+    bool paused_here = pause();
+    m_base.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+    m_dropped.store(0, std::memory_order_relaxed);
+    if (paused_here) resume();
+}
+
+// ---------------------------------------------------------------------
+// Replay
+// ---------------------------------------------------------------------
+static bool is_transfer(I2CTraceOp op) {
+    return op == I2CTraceOp::TRANSMIT || op == I2CTraceOp::RECEIVE || op == I2CTraceOp::TRANSMIT_RECEIVE;
+}
+
+esp_err_t I2CTrace::replay(const I2CTraceRecord *recs, size_t count, I2CSimBackend &sim,
+                           uint32_t scl_hz, I2CTraceReplayStats *out,
+                           i2c_trace_replay_cb_t cb, void *cb_arg) {
+    if (!recs && count) return ESP_ERR_INVALID_ARG;
+    I2CTraceReplayStats st = {};
+
+    // The trace may start mid-session: open the controller, attach the
+    // devices that answered and add handles whose ADD_DEVICE is missing
+    sim.open();
+    bool handled[I2C_ADDR_SLOTS] = {};
+    for (size_t i = 0; i < count; i++) {
+        const I2CTraceRecord &r = recs[i];
+        if (r.addr >= I2C_ADDR_SLOTS) continue;
+        bool answered = (is_transfer(r.op) || r.op == I2CTraceOp::PROBE) && r.err == ESP_OK;
+        if (answered && !sim.device(r.addr)) sim.attach(r.addr);
+        if (handled[r.addr]) continue;
+        if (r.op == I2CTraceOp::ADD_DEVICE || r.op == I2CTraceOp::REMOVE_DEVICE) {
+            handled[r.addr] = true;
+        } else if (is_transfer(r.op)) {
+            sim.add_device(r.addr, scl_hz);
+            handled[r.addr] = true;
+        }
+    }
+
+    uint8_t wbuf[I2C_TRACE_REPLAY_MAX_LEN], rbuf[I2C_TRACE_REPLAY_MAX_LEN];
+    for (size_t i = 0; i < count; i++) {
+        const I2CTraceRecord &r = recs[i];
+        uint64_t t0 = sim.now_us();
+        esp_err_t err = ESP_OK;
+
+        if (is_transfer(r.op) || r.op == I2CTraceOp::PROBE) {
+            // Recorded failure: the same fault, for this transaction only
+            if (r.err == ESP_ERR_TIMEOUT) {
+                sim.inject({I2CSimFaultKind::TIMEOUT, r.addr, 0, 1, I2CRecoveryTier::BUS_CLEAR});
+            } else if (r.err != ESP_OK) {
+                sim.inject({I2CSimFaultKind::NACK, r.addr, 0, 1, I2CRecoveryTier::BUS_CLEAR});
+            }
+            int tmo = r.err == ESP_ERR_TIMEOUT ? (int)((r.dur_us + 500) / 1000) : -1;
+
+            // Bytes past the recorded ones are written as zeros
+            size_t wlen = r.wlen < sizeof(wbuf) ? r.wlen : sizeof(wbuf);
+            size_t rlen = r.rlen < sizeof(rbuf) ? r.rlen : sizeof(rbuf);
+            memset(wbuf, 0, wlen);
+            memcpy(wbuf, r.wdata, wlen < I2C_TRACE_DATA_BYTES ? wlen : I2C_TRACE_DATA_BYTES);
+
+            // Preload what the device answered, so device hooks and the
+            // callback see the recorded bytes
+            I2CSimDevice *dev = sim.device(r.addr);
+            if (dev && r.err == ESP_OK && rlen) {
+                uint8_t reg = r.op == I2CTraceOp::TRANSMIT_RECEIVE && wlen ? r.wdata[0] : dev->pointer;
+                for (size_t k = 0; k < rlen && k < I2C_TRACE_DATA_BYTES; k++)
+                    dev->regs[(uint8_t)(reg + k)] = r.rdata[k];
+            }
+
+            switch (r.op) {
+            case I2CTraceOp::TRANSMIT:         err = sim.transmit(r.addr, wbuf, wlen, tmo); break;
+            case I2CTraceOp::RECEIVE:          err = sim.receive(r.addr, rbuf, rlen, tmo); break;
+            case I2CTraceOp::TRANSMIT_RECEIVE: err = sim.transmit_receive(r.addr, wbuf, wlen, rbuf, rlen, tmo); break;
+            default:                           err = sim.probe(r.addr, tmo); break;
+            }
+            sim.clear_faults();   // drop a fault the simulator did not consume
+        } else {
+            switch (r.op) {
+            case I2CTraceOp::ADD_DEVICE:    err = sim.add_device(r.addr, (uint32_t)r.wlen * 1000); break;
+            case I2CTraceOp::REMOVE_DEVICE: sim.remove_device(r.addr); break;
+            case I2CTraceOp::OPEN:          err = sim.open(); break;
+            case I2CTraceOp::CLOSE:         sim.close(); break;
+            case I2CTraceOp::BUS_RESET:     err = sim.bus_reset(); break;
+            case I2CTraceOp::BUS_CLEAR:     sim.bus_clear(); break;
+            case I2CTraceOp::PERIPH_RESET:  sim.periph_reset(); break;
+            default:                        continue;   // bus event, nothing on the wire
+            }
+        }
+
+        uint32_t modelled = (uint32_t)(sim.now_us() - t0);
+        st.operations++;
+        if (err != r.err) st.mismatches++;
+        st.recorded_us += r.dur_us;
+        st.modelled_us += modelled;
+        if (cb) cb(r, err, modelled, cb_arg);
+    }
+
+    if (out) *out = st;
+    return ESP_OK;
+}
+
+// ---------------------------------------------------------------------
+// I2CBus side
+// ---------------------------------------------------------------------
+esp_err_t I2CBus::attach_trace(I2CTrace *trace) {
+    if (!trace) return ESP_ERR_INVALID_ARG;
+    I2CBusLock lock(*this);
+    if (lock.status() != ESP_OK) return lock.status();
+    if (m_trace) return ESP_ERR_INVALID_STATE;
+    trace->m_inner = m_backend;
+    m_backend = trace;
+    m_trace = trace;
+    return ESP_OK;
+}
+
+void I2CBus::trace_retry(uint8_t addr, esp_err_t err, int attempt) {
+    m_trace->event(I2CTraceOp::RETRY, addr, err, (uint16_t)attempt, 0);
+}
+
+esp_err_t I2CBus::detach_trace() {
+    I2CBusLock lock(*this);
+    if (lock.status() != ESP_OK) return lock.status();
+    if (!m_trace) return ESP_ERR_INVALID_STATE;
+    m_backend = m_trace->m_inner;
+    m_trace->m_inner = nullptr;
+    m_trace = nullptr;
+    return ESP_OK;
+}
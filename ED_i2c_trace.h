@@ -0,0 +1,147 @@
+#ifndef ED_I2C_TRACE_H
+#define ED_I2C_TRACE_H
+
+#include "ED_i2c.h"
+#include <atomic>
+
+#define I2C_TRACE_DATA_BYTES   4            // first bytes kept of each direction
+#define I2C_TRACE_MAGIC        0x54433249   // "I2CT", little endian
+#define I2C_TRACE_VERSION      1
+
+class I2CSimBackend;
+
+enum class I2CTraceOp : uint8_t {
+    // Backend operations
+    TRANSMIT,
+    RECEIVE,
+    TRANSMIT_RECEIVE,
+    PROBE,
+    ADD_DEVICE,      // wlen = SCL speed in kHz
+    REMOVE_DEVICE,
+    OPEN,
+    CLOSE,
+    BUS_RESET,
+    BUS_CLEAR,
+    PERIPH_RESET,
+    // I2CBus events
+    RETRY,           // attempt number wlen failed with err and is retried
+    RECOVERY,        // tier wlen (I2CRecoveryTier) ran for dur_us; err = ESP_OK if the bus answered
+    BREAKER_TRIP,    // device quarantined after err
+};
+
+/// One trace entry, 32 bytes. Also the binary dump format (little endian).
+struct I2CTraceRecord {
+    int64_t    ts_us;                          // esp_timer time at the start
+    uint32_t   dur_us;
+    esp_err_t  err;
+    uint16_t   wlen;
+    uint16_t   rlen;
+    I2CTraceOp op;
+    uint8_t    addr;
+    uint8_t    wdata[I2C_TRACE_DATA_BYTES];
+    uint8_t    rdata[I2C_TRACE_DATA_BYTES];   // valid only if err == ESP_OK
+};
+static_assert(sizeof(I2CTraceRecord) == 32, "trace record layout is the dump format");
+
+/// Header in front of the records of a binary dump
+struct I2CTraceHeader {
+    uint32_t magic;         // I2C_TRACE_MAGIC
+    uint16_t version;       // I2C_TRACE_VERSION
+    uint16_t record_size;   // sizeof(I2CTraceRecord)
+    uint32_t count;         // records that follow, oldest first
+    uint32_t lost;          // older records overwritten by the ring or dropped during a dump
+};
+
+/// Receives a binary dump piece by piece (UART, file, socket...)
+typedef esp_err_t (*i2c_trace_sink_t)(const void *data, size_t len, void *arg);
+
+/// Per-record replay callback: the record, the simulator's result, its modelled time
+typedef void (*i2c_trace_replay_cb_t)(const I2CTraceRecord &rec, esp_err_t err, uint32_t modelled_us, void *arg);
+
+struct I2CTraceReplayStats {
+    uint32_t operations;    // backend operations replayed (bus events are skipped)
+    uint32_t mismatches;    // replayed result differs from the recorded one
+    uint64_t recorded_us;   // recorded time of the replayed operations
+    uint64_t modelled_us;   // simulator bus time for the same operations
+};
+
+/**
+ * @brief Fixed-size RAM ring of bus transactions, see I2CBus::attach_trace().
+ *
+ * While attached, the trace sits between the bus and its backend and
+ * records every backend operation (timestamp, address, lengths, first
+ * bytes, result, duration), plus the bus's retries, recovery tiers and
+ * breaker trips. The oldest records are overwritten. Storage is supplied
+ * by the caller; nothing is allocated.
+ *
+ * Records are written by the task holding the bus lock. A snapshot or a
+ * dump pauses recording instead of blocking the bus: records made
+ * meanwhile are dropped and counted as lost.
+ */
+class I2CTrace : public I2CBackend {
+public:
+    // `capacity` is rounded down to a power of two
+    I2CTrace(I2CTraceRecord *buf, size_t capacity);
+    I2CTrace(const I2CTrace &) = delete;
+    I2CTrace &operator=(const I2CTrace &) = delete;
+
+    // Copies up to `max` of the newest records, oldest first
+    size_t    snapshot(I2CTraceRecord *out, size_t max, uint32_t *lost = nullptr);
+    // Header, then every record in the ring, oldest first
+    esp_err_t dump(i2c_trace_sink_t sink, void *arg);
+    // Text form of the newest `last` records (0 = all)
+    void      log(size_t last = 0);
+    // Records written since the last clear(), overwritten ones included
+    uint32_t  recorded() const {
+        return m_head.load(std::memory_order_acquire) - m_base.load(std::memory_order_acquire);
+    }
+    void      clear();
+
+    // Replays backend operations on `sim` with their recorded outcome:
+    // failures are injected as faults, recorded read bytes are preloaded in
+    // the device registers, and devices seen answering are attached if
+    // missing. Bus events are skipped. `scl_hz` applies to devices whose
+    // ADD_DEVICE fell out of the trace.
+    static esp_err_t replay(const I2CTraceRecord *recs, size_t count, I2CSimBackend &sim,
+                            uint32_t scl_hz, I2CTraceReplayStats *out,
+                            i2c_trace_replay_cb_t cb = nullptr, void *cb_arg = nullptr);
+    static const char *op_name(I2CTraceOp op);
+
+    // I2CBackend: forwarded to the traced backend
+    esp_err_t open() override;
+    void      close() override;
+    bool      is_open() const override { return m_inner->is_open(); }
+    esp_err_t add_device(uint8_t addr, uint32_t scl_hz) override;
+    void      remove_device(uint8_t addr) override;
+    esp_err_t transmit(uint8_t addr, const uint8_t *data, size_t len, int timeout_ms) override;
+    esp_err_t transmit_reg(uint8_t addr, uint8_t reg, const uint8_t *data, size_t len,
+                           int timeout_ms) override;
+    esp_err_t receive(uint8_t addr, uint8_t *data, size_t len, int timeout_ms) override;
+    esp_err_t transmit_receive(uint8_t addr, const uint8_t *wdata, size_t wlen,
+                               uint8_t *rdata, size_t rlen, int timeout_ms) override;
+    esp_err_t probe(uint8_t addr, int timeout_ms) override;
+    esp_err_t bus_reset() override;
+    void      bus_clear() override;
+    void      periph_reset() override;
+
+private:
+    friend class I2CBus;
+
+    void record(I2CTraceOp op, uint8_t addr, int64_t t0, esp_err_t err,
+                const uint8_t *wdata, size_t wlen, const uint8_t *rdata, size_t rlen);
+    void event(I2CTraceOp op, uint8_t addr, esp_err_t err, uint16_t arg, uint32_t dur_us);
+    bool pause();
+    void resume() { m_paused.store(false, std::memory_order_release); }
+    // Paused: index range still intact in the ring
+    void window(uint32_t *first, uint32_t *end) const;
+
+    I2CTraceRecord         *m_buf;
+    uint32_t                m_mask;
+    I2CBackend             *m_inner;
+    std::atomic<uint32_t>   m_head;      // index of the next record, never reset
+    std::atomic<uint32_t>   m_base;      // m_head at the last clear()
+    std::atomic<uint32_t>   m_dropped;   // records dropped while paused
+    std::atomic<bool>       m_paused;
+};
+
+#endif // ED_I2C_TRACE_H
@@ -0,0 +1,95 @@
+#pragma once
+
+// #region StdManifest
+/**
+ * @file ED_inplace_function.h
+ * @brief std::function replacement with inline storage: never touches the heap.
+ *
+ * Any callable (lambda, functor, function pointer) whose size fits in
+ * `Capacity` bytes is stored by value inside the object. Larger callables are
+ * rejected at compile time instead of silently allocating.
+ */
+// #endregion
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <typename Sig, size_t Capacity = 2 * sizeof(void *)>
+class InplaceFunction;
+
+template <typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+public:
+    InplaceFunction() noexcept : m_invoke(nullptr), m_manage(nullptr) {}
+    InplaceFunction(std::nullptr_t) noexcept : InplaceFunction() {}
+
+    template <typename F,
+              typename D = typename std::decay<F>::type,
+              typename = typename std::enable_if<!std::is_same<D, InplaceFunction>::value>::type>
+    InplaceFunction(F &&f) : InplaceFunction() {
+        static_assert(sizeof(D) <= Capacity, "callable too large for InplaceFunction storage");
+        static_assert(alignof(D) <= alignof(void *), "callable over-aligned for InplaceFunction storage");
+        ::new (static_cast<void *>(m_storage)) D(std::forward<F>(f));
+        m_invoke = &invoke_impl<D>;
+        m_manage = &manage_impl<D>;
+    }
+
+    InplaceFunction(const InplaceFunction &o) : InplaceFunction() {
+        if (o.m_manage) {
+            o.m_manage(m_storage, o.m_storage, Op::COPY);
+            m_invoke = o.m_invoke;
+            m_manage = o.m_manage;
+        }
+    }
+
+    InplaceFunction &operator=(const InplaceFunction &o) {
+        if (this != &o) {
+            reset();
+            if (o.m_manage) {
+                o.m_manage(m_storage, o.m_storage, Op::COPY);
+                m_invoke = o.m_invoke;
+                m_manage = o.m_manage;
+            }
+        }
+        return *this;
+    }
+
+    InplaceFunction &operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    ~InplaceFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return m_invoke != nullptr; }
+
+    R operator()(Args... args) const {
+        return m_invoke(const_cast<unsigned char *>(m_storage), std::forward<Args>(args)...);
+    }
+
+    void reset() noexcept {
+        if (m_manage) m_manage(m_storage, nullptr, Op::DESTROY);
+        m_invoke = nullptr;
+        m_manage = nullptr;
+    }
+
+private:
+    enum class Op { COPY, DESTROY };
+
+    template <typename D>
+    static R invoke_impl(void *obj, Args... args) {
+        return (*static_cast<D *>(obj))(std::forward<Args>(args)...);
+    }
+
+    template <typename D>
+    static void manage_impl(void *dst, const void *src, Op op) {
+        if (op == Op::COPY) ::new (dst) D(*static_cast<const D *>(src));
+        else static_cast<D *>(dst)->~D();
+    }
+
+    alignas(void *) unsigned char m_storage[Capacity];
+    R    (*m_invoke)(void *, Args...);
+    void (*m_manage)(void *, const void *, Op);
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+// #region StdManifest
+/**
+ * @file ED_seqlock.h
+ * @brief Sequence lock: readers never block, never mask interrupts.
+ *
+ * A small, trivially copyable value (a clock reference, a calibration set)
+ * written rarely and read often. The writer bumps a sequence counter to an
+ * odd value, stores the value and bumps it back to even; a reader copies the
+ * value and starts over if the counter was odd or moved meanwhile.
+ *
+ * The value is kept as 32-bit atomic words, so no access ever falls back to
+ * the lock-based 64-bit atomics of 32-bit targets.
+ */
+// #endregion
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock holds trivially copyable values only");
+
+public:
+    constexpr SeqLock() : m_seq(0), m_words() {}
+    explicit SeqLock(const T &v) : SeqLock() { store(v); }
+    SeqLock(const SeqLock &) = delete;
+    SeqLock &operator=(const SeqLock &) = delete;
+
+    // One writer at a time: concurrent writers must be serialized by the caller.
+    // A writer that cannot be preempted by a reader on its core (critical
+    // section, or the only task touching the value) keeps readers from spinning.
+    void store(const T &v) {
+        uint32_t w[WORDS] = {};
+        memcpy(w, &v, sizeof(T));
+        uint32_t s = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) m_words[i].store(w[i], std::memory_order_relaxed);
+        m_seq.store(s + 2, std::memory_order_release);
+    }
+
+    // Consistent copy of the last stored value; returns the number of retries
+    uint32_t load(T *out) const {
+        uint32_t w[WORDS];
+        for (uint32_t retries = 0;; retries++) {
+            uint32_t s0 = m_seq.load(std::memory_order_acquire);
+            if (s0 & 1) continue;   // write in progress
+            for (size_t i = 0; i < WORDS; i++) w[i] = m_words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_seq.load(std::memory_order_relaxed) == s0) {
+                memcpy(out, w, sizeof(T));
+                return retries;
+            }
+        }
+    }
+
+    T load() const {
+        T v;
+        load(&v);
+        return v;
+    }
+
+    // Even and incremented by 2 per store: a cheap "changed since" check
+    uint32_t sequence() const { return m_seq.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> m_seq;
+    std::atomic<uint32_t> m_words[WORDS];
+};
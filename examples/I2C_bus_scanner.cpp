@@ -1,6 +1,6 @@
 /**
 * @file main.cpp
-* @brief Standalone full-range I2C scanner (0x01 to 0x7F).
+* @brief Full-range I2C scanner (0x01 to 0x7F) using the cached I2CBus::scan().
  *
  * @author Emanuele Dolis (emanuele.dolis@gmail.com)
  * @version GIT_VERSION: v1.1.3-5-g511346d-dirty
@@ -15,7 +15,8 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "esp_err.h"
-#include "driver/i2c_master.h"
+#include "esp_timer.h"
+#include "ED_i2c.h"
 
 // ---- Pin definitions ----
 #define I2C_SDA_GPIO         GPIO_NUM_22
@@ -43,25 +44,26 @@ extern "C" void app_main(void) {
     printf("SDA=GPIO%d, SCL=GPIO%d @ %d Hz\n\n", I2C_SDA_GPIO, I2C_SCL_GPIO, I2C_FREQ_HZ);
 
     // ---- 1. Configure I2C bus ----
-    i2c_master_bus_config_t bus_cfg = {
-        .i2c_port = I2C_PORT,
-        .sda_io_num = I2C_SDA_GPIO,
-        .scl_io_num = I2C_SCL_GPIO,
-        .clk_source = I2C_CLK_SRC_DEFAULT,
-        .glitch_ignore_cnt = 7,
-        .flags = {
-            .enable_internal_pullup = true,
-        },
-    };
-
-    i2c_master_bus_handle_t bus_handle;
-    esp_err_t err = i2c_new_master_bus(&bus_cfg, &bus_handle);
+    I2CBus bus(I2C_PORT, I2C_SDA_GPIO, I2C_SCL_GPIO, I2C_FREQ_HZ);
+
+    // ---- 2. Scan full range 0x01 to 0x7F in one pass ----
+    // (skip 0x00 which is general call)
+    const I2CAddrMap candidates = I2CAddrMap::range(0x01, 0x7F);
+    I2CAddrMap present;
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = bus.scan(&present, &candidates);
+    int64_t scan_us = esp_timer_get_time() - t0;
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to create I2C bus: %s", esp_err_to_name(err));
+        ESP_LOGE(TAG, "Scan failed: %s", esp_err_to_name(err));
         while (1) vTaskDelay(pdMS_TO_TICKS(1000));
     }
 
-    // ---- 2. Scan full range 0x01 to 0x7F ----
+    // A second call is answered from the presence cache
+    I2CAddrMap again;
+    t0 = esp_timer_get_time();
+    bus.scan(&again, &candidates);
+    int64_t cached_us = esp_timer_get_time() - t0;
+
     printf("     ");
     for (int col = 0; col < 16; col++) {
         printf(" %02X ", col);
@@ -73,25 +75,16 @@ extern "C" void app_main(void) {
     }
     printf("\n");
 
-    int found_count = 0;
-    bool found_as7341 = false;
-
-    // Start from 0x01 (skip 0x00 which is general call)
-    for (uint8_t addr = 0x01; addr <= 0x7F; addr++) {
+    for (uint8_t addr = 0x00; addr <= 0x7F; addr++) {
         // Print new row every 16 addresses
         if ((addr & 0x0F) == 0x00) {
             printf("0x%02X: ", addr);
         }
 
-        // Probe with 50ms timeout
-        err = i2c_master_probe(bus_handle, addr, 50);
-
-        if (err == ESP_OK) {
+        if (!candidates.test(addr)) {
+            printf("    ");
+        } else if (present.test(addr)) {
             printf(COLOR_GREEN " OK " COLOR_RESET);
-            found_count++;
-            if (addr == 0x39) {
-                found_as7341 = true;
-            }
         } else {
             printf(COLOR_YELLOW " -- " COLOR_RESET);
         }
@@ -103,14 +96,16 @@ extern "C" void app_main(void) {
     }
 
     // ---- 3. Summary ----
+    int found_count = (int)present.count();
     printf("\n\n╔══════════════════════════════════════════════════════════╗\n");
     printf("║                      SCAN RESULTS                      ║\n");
     printf("╚══════════════════════════════════════════════════════════╝\n");
     printf("Total devices found: " COLOR_GREEN "%d" COLOR_RESET "\n", found_count);
+    printf("Scan time: %lld us (cached: %lld us)\n", (long long)scan_us, (long long)cached_us);
 
     // Check specifically for 0x39 (AS7341)
     printf("\nChecking for AS7341 at 0x39... ");
-    if (found_as7341) {
+    if (present.test(0x39)) {
         printf(COLOR_GREEN "✓ FOUND" COLOR_RESET "\n");
     } else {
         printf(COLOR_RED "✗ NOT FOUND" COLOR_RESET "\n");
@@ -121,13 +116,12 @@ extern "C" void app_main(void) {
         printf("  □ Check sensor orientation/pinout\n");
     }
 
-    // ---- 4. List all found addresses ----
+    // ---- 4. List all found addresses (from the bitmap, no second pass) ----
     if (found_count > 0) {
         printf("\nFound at addresses: ");
         bool first = true;
         for (uint8_t addr = 0x01; addr <= 0x7F; addr++) {
-            err = i2c_master_probe(bus_handle, addr, 20);
-            if (err == ESP_OK) {
+            if (present.test(addr)) {
                 if (!first) printf(", ");
                 printf("0x%02X", addr);
                 first = false;
@@ -136,9 +130,6 @@ extern "C" void app_main(void) {
         printf("\n");
     }
 
-    // ---- 5. Clean up ----
-    i2c_del_master_bus(bus_handle);
-
     while (1) {
         vTaskDelay(pdMS_TO_TICKS(1000));
     }
@@ -0,0 +1,85 @@
+/**
+* @file I2C_drdy_acquisition.cpp
+* @brief Interrupt-driven acquisition from an MPU-6050 using its INT pin.
+*
+* The sensor samples at 100 Hz and raises INT when a new sample is in its
+* output registers. I2CAcquisition timestamps the edge in the ISR, reads
+* the 14 bytes of accel/temp/gyro data right away and hands the sample to
+* the consumer task below through a lock-free ring.
+*
+* Wiring: SDA GPIO21, SCL GPIO22, MPU-6050 INT -> GPIO6.
+ *
+ * @author Emanuele Dolis (emanuele.dolis@gmail.com)
+ * @date 2026-07-06
+ */
+
+#include <cstdio>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "ED_i2c.h"
+#include "ED_i2c_acq.h"
+
+#define I2C_PORT      I2C_NUM_0
+#define SDA_PIN       GPIO_NUM_21
+#define SCL_PIN       GPIO_NUM_22
+#define I2C_FREQ      400000
+#define DRDY_PIN      GPIO_NUM_6
+#define MPU_ADDR      0x68
+
+static const char *TAG = "i2c_drdy";
+
+static esp_err_t mpu6050_setup(I2CBus &bus) {
+    static const uint8_t init[][2] = {
+        {0x6B, 0x00},   // PWR_MGMT_1: wake up
+        {0x19, 9},      // SMPLRT_DIV: 1 kHz / (1 + 9) = 100 Hz
+        {0x1A, 0x03},   // CONFIG: DLPF 44 Hz (1 kHz internal rate)
+        {0x37, 0x10},   // INT_PIN_CFG: push-pull, active high, cleared by any read
+        {0x38, 0x01},   // INT_ENABLE: data ready
+    };
+    for (const auto &w : init) {
+        esp_err_t err = bus.write(MPU_ADDR, w, 2);
+        if (err != ESP_OK) return err;
+    }
+    return ESP_OK;
+}
+
+static int16_t be16(const uint8_t *p) { return (int16_t)((p[0] << 8) | p[1]); }
+
+extern "C" void app_main() {
+    I2CBus bus(I2C_PORT, SDA_PIN, SCL_PIN, I2C_FREQ);
+    if (mpu6050_setup(bus) != ESP_OK) {
+        ESP_LOGE(TAG, "MPU-6050 not responding at 0x%02X", MPU_ADDR);
+        return;
+    }
+
+    I2CAcquisition acq(bus);
+    int ch;
+    I2CReadDesc desc = {MPU_ADDR, 0x3B, 14};   // ACCEL_XOUT_H .. GYRO_ZOUT_L
+    ESP_ERROR_CHECK(acq.bind(DRDY_PIN, GPIO_INTR_POSEDGE, desc, &ch));
+    acq.set_consumer(ch, xTaskGetCurrentTaskHandle());
+    ESP_ERROR_CHECK(acq.start());
+
+    int64_t last_ts = 0;
+    uint32_t n = 0;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        I2CSample s;
+        while (acq.pop(ch, &s)) {
+            if (s.status != ESP_OK) continue;
+            if (++n % 100 == 0) {
+                printf("seq %6lu  t=%lld us  dt=%lld us  ax=%6d ay=%6d az=%6d\n", (unsigned long)s.seq,
+                       (long long)s.timestamp_us, (long long)(s.timestamp_us - last_ts),
+                       be16(&s.data[0]), be16(&s.data[2]), be16(&s.data[4]));
+            }
+            last_ts = s.timestamp_us;
+        }
+        if (n % 1000 == 0) {
+            I2CAcqStats st;
+            acq.get_stats(ch, &st);
+            ESP_LOGI(TAG, "irqs %lu, samples %lu, coalesced %lu, overflows %lu, errors %lu",
+                     (unsigned long)st.irqs, (unsigned long)st.samples, (unsigned long)st.coalesced,
+                     (unsigned long)st.overflows, (unsigned long)st.read_errors);
+        }
+    }
+}
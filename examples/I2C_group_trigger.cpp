@@ -0,0 +1,105 @@
+/**
+* @file I2C_group_trigger.cpp
+* @brief Three temperature sensors sampled at the same instant, first with a
+* general call, then with back-to-back trigger writes. Runs on the simulator,
+* so it builds for the chip and for the IDF linux target.
+*
+* Each virtual sensor starts a conversion on the general-call command 0x04 or
+* on a write of 0x01 to its CONFIG register, and latches a sample counter in
+* its result registers, which shows that all members sampled in the same round.
+ *
+ * @author Emanuele Dolis (emanuele.dolis@gmail.com)
+ * @date 2026-08-03
+ */
+
+#include <cstdio>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "ED_i2c.h"
+#include "ED_i2c_sim.h"
+#include "ED_i2c_group.h"
+
+#define I2C_FREQ       400000
+#define SENSORS        3
+#define SENSOR_ADDR0   0x48
+#define REG_RESULT     0x00
+#define REG_CONFIG     0x01
+#define CFG_ONE_SHOT   0x01
+#define GC_START_CONV  0x04
+#define SETTLE_US      2000    // conversion time
+
+static const char *TAG = "i2c_group";
+
+static uint16_t conversions[SENSORS];
+
+static void convert(I2CSimDevice &dev, void *arg) {
+    int i = (int)(intptr_t)arg;
+    uint16_t v = ++conversions[i];
+    dev.regs[REG_RESULT] = (uint8_t)(v >> 8);
+    dev.regs[REG_RESULT + 1] = (uint8_t)v;
+}
+
+static void on_general_call(I2CSimDevice &dev, const uint8_t *data, size_t len, void *arg) {
+    if (len == 1 && data[0] == GC_START_CONV) convert(dev, arg);
+}
+
+static void on_register(I2CSimDevice &dev, uint8_t reg, bool write, void *arg) {
+    if (write && reg == REG_CONFIG && dev.regs[REG_CONFIG] & CFG_ONE_SHOT) {
+        dev.regs[REG_CONFIG] &= (uint8_t)~CFG_ONE_SHOT;
+        convert(dev, arg);
+    }
+}
+
+static void run(I2CGroup &group, uint8_t result[][2], const char *name) {
+    for (int round = 0; round < 3; round++) {
+        I2CGroupSample s;
+        esp_err_t err = group.sample(SETTLE_US, &s);
+        if (err != ESP_OK) ESP_LOGW(TAG, "%s: %s", name, esp_err_to_name(err));
+        printf("%-13s t=%lld us skew=%lu us  %u/%u triggered, %u collected:", name, (long long)s.ts_us,
+               (unsigned long)s.skew_us, s.triggered, (unsigned)group.size(), s.collected);
+        for (int i = 0; i < SENSORS; i++) {
+            if (group.status(i) == ESP_OK) printf(" %u", (unsigned)((result[i][0] << 8) | result[i][1]));
+            else printf(" --");
+        }
+        printf("\n");
+    }
+}
+
+extern "C" void app_main() {
+    I2CSimBackend sim;
+    for (int i = 0; i < SENSORS; i++) {
+        I2CSimDevice *d = sim.attach(SENSOR_ADDR0 + i);
+        d->general_call = on_general_call;
+        d->hook = on_register;
+        d->hook_arg = (void *)(intptr_t)i;
+    }
+    I2CBus bus(sim, I2C_FREQ);
+
+    static uint8_t result[SENSORS][2];
+    static const uint8_t gc_cmd[] = {GC_START_CONV};
+
+    // --- General call: one write, every sensor converts at its STOP -----
+    I2CGroup gc(bus, I2CTriggerMode::GENERAL_CALL, gc_cmd, sizeof(gc_cmd));
+    for (int i = 0; i < SENSORS; i++) {
+        I2CGroupMember m = {(uint8_t)(SENSOR_ADDR0 + i), {}, 0, REG_RESULT, result[i], 2};
+        ESP_ERROR_CHECK(gc.add(m));
+    }
+    run(gc, result, "general call");
+
+    // --- Back to back: one trigger write per sensor ------------------------
+    I2CGroup b2b(bus, I2CTriggerMode::BACK_TO_BACK);
+    for (int i = 0; i < SENSORS; i++) {
+        I2CGroupMember m = {(uint8_t)(SENSOR_ADDR0 + i), {REG_CONFIG, CFG_ONE_SHOT}, 2, REG_RESULT, result[i], 2};
+        ESP_ERROR_CHECK(b2b.add(m));
+    }
+    run(b2b, result, "back to back");
+
+    // The middle sensor misses one trigger: it is left out of that collect
+    sim.inject({I2CSimFaultKind::NACK, SENSOR_ADDR0 + 1, 0, 1, I2CRecoveryTier::DEVICE_SOFT});
+    run(b2b, result, "one NACK");
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
@@ -0,0 +1,119 @@
+/**
+* @file I2C_overhead_bench.cpp
+* @brief Per-call bookkeeping overhead of I2CBus: legacy std::map tables vs
+* the flat 128-slot address table, plus heap use of real transactions.
+*
+* Part 1 replays the bookkeeping the old I2C_RETRY_WITH_RECOVERY macro did on
+* every successful call (handle lookup, failure reset, callback lookup) on
+* three std::map, and the same work on a flat table. No bus needed.
+* Part 2 runs real write_then_read calls and checks that the heap does not move.
+ *
+ * @author Emanuele Dolis (emanuele.dolis@gmail.com)
+ * @date 2026-06-20
+ */
+
+#include <cstdio>
+#include <map>
+#include <functional>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "ED_i2c.h"
+
+#define CONFIG_IDF_TARGET_ESP32C6
+#include "ed_board.h"
+
+#define I2C_FREQ     400000
+#define DEV_ADDR     0x44       // OPT3001, any ACKing device will do
+#define ITERATIONS   100000
+#define BUS_CALLS    1000
+
+static const char *TAG = "i2c_bench";
+
+// ---- legacy bookkeeping model (three std::map, as before) ----
+struct LegacyTables {
+    std::map<uint8_t, void *> devices;
+    std::map<uint8_t, std::function<esp_err_t(void)>> callbacks;
+    std::map<uint8_t, int> failures;
+};
+
+// ---- flat model (one descriptor per address) ----
+struct FlatSlot {
+    void *handle;
+    I2CRecoveryCallback recovery;
+    uint8_t failures;
+    bool known;
+};
+
+static void __attribute__((noinline)) legacy_call(LegacyTables &t, uint8_t addr, void **out) {
+    auto it = t.devices.find(addr);
+    *out = (it != t.devices.end()) ? it->second : nullptr;
+    t.failures[addr] = 0;                       // may allocate on first use
+    auto cb = t.callbacks.find(addr);
+    if (cb == t.callbacks.end()) __asm__ volatile("" ::: "memory");
+}
+
+static void __attribute__((noinline)) flat_call(FlatSlot *slots, uint8_t addr, void **out) {
+    FlatSlot &s = slots[addr];
+    *out = s.handle;
+    s.failures = 0;
+    if (!s.recovery) __asm__ volatile("" ::: "memory");
+}
+
+static void bench_bookkeeping() {
+    static int dummy[8];
+    LegacyTables legacy;
+    static FlatSlot flat[I2C_ADDR_SLOTS] = {};
+    // a realistic population: 6 devices on the bus
+    const uint8_t addrs[] = {0x10, 0x23, 0x39, 0x44, 0x48, 0x76};
+    for (int i = 0; i < 6; i++) {
+        legacy.devices[addrs[i]] = &dummy[i];
+        flat[addrs[i]].handle = &dummy[i];
+        flat[addrs[i]].known = true;
+    }
+
+    void *h;
+    size_t heap0 = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < ITERATIONS; i++) legacy_call(legacy, addrs[i % 6], &h);
+    int64_t t1 = esp_timer_get_time();
+    size_t heap1 = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    for (int i = 0; i < ITERATIONS; i++) flat_call(flat, addrs[i % 6], &h);
+    int64_t t2 = esp_timer_get_time();
+    size_t heap2 = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    ESP_LOGI(TAG, "bookkeeping, %d calls:", ITERATIONS);
+    ESP_LOGI(TAG, "  std::map : %6.3f us/call, heap delta %d B",
+             (double)(t1 - t0) / ITERATIONS, (int)heap0 - (int)heap1);
+    ESP_LOGI(TAG, "  flat     : %6.3f us/call, heap delta %d B",
+             (double)(t2 - t1) / ITERATIONS, (int)heap1 - (int)heap2);
+}
+
+static void bench_bus(I2CBus &i2c) {
+    uint8_t reg = 0x7E, id[2];
+    if (i2c.write_then_read(DEV_ADDR, &reg, 1, id, 2) != ESP_OK) {   // warm-up, creates the handle
+        ESP_LOGW(TAG, "no device at 0x%02X, skipping bus benchmark", DEV_ADDR);
+        return;
+    }
+    size_t heap0 = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < BUS_CALLS; i++) i2c.write_then_read(DEV_ADDR, &reg, 1, id, 2);
+    int64_t t1 = esp_timer_get_time();
+    size_t heap1 = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    ESP_LOGI(TAG, "write_then_read(1+2 B) @ %d Hz: %.1f us/call, heap delta %d B",
+             I2C_FREQ, (double)(t1 - t0) / BUS_CALLS, (int)heap0 - (int)heap1);
+}
+
+extern "C" void app_main() {
+    esp_log_level_set("i2c.master", ESP_LOG_NONE);
+
+    bench_bookkeeping();
+
+    I2CBus i2c(I2C_NUM_0, (gpio_num_t)ED_I2C_SDA, (gpio_num_t)ED_I2C_SCL, I2C_FREQ);
+    bench_bus(i2c);
+
+    while (1) vTaskDelay(pdMS_TO_TICKS(1000));
+}
@@ -0,0 +1,101 @@
+/**
+* @file I2C_retry_policies.cpp
+* @brief Checks each retry policy on the simulated backend: how many
+* attempts a call makes and where soft recovery and the bus ladder run
+* between them. Builds for the chip and for the IDF linux target.
+*
+* The device NACKs every transaction until the faults are cleared. Its
+* recovery callback only counts, so soft recovery always succeeds and the
+* ladder runs exactly where the policy puts it; the probe after the bus
+* clear gets a clean NACK, so each ladder run stops at its first tier.
+* Every row prints the expected and measured counts and PASS or FAIL.
+ *
+ * @author Emanuele Dolis (emanuele.dolis@gmail.com)
+ * @date 2026-08-29
+ */
+
+#include <cstdio>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "ED_i2c.h"
+#include "ED_i2c_sim.h"
+
+#define I2C_FREQ     400000
+#define DEV_ADDR     0x40
+
+static const char *TAG = "i2c_retry_policies";
+
+struct Expected {
+    uint32_t  attempts;
+    uint32_t  soft;        // soft recoveries (recovery callback runs)
+    uint32_t  ladders;     // bus ladder runs
+    bool      quarantined;
+};
+
+static int failed_rows = 0;
+
+template <typename Policy>
+static void check(I2CBus &bus, I2CSimBackend &sim, const char *name, const Expected &want) {
+    I2CSimFault nack = {I2CSimFaultKind::NACK, DEV_ADDR, 0, 0, I2CRecoveryTier::BUS_CLEAR};
+    sim.inject(nack);
+
+    I2CBusStats bs0, bs1;
+    I2CRecoveryStats rs0, rs1;
+    bus.get_stats(&bs0);
+    bus.get_recovery_stats(&rs0);
+
+    uint8_t v;
+    esp_err_t err = bus.read<Policy>(DEV_ADDR, &v, 1);
+
+    bus.get_stats(&bs1);
+    bus.get_recovery_stats(&rs1);
+    I2CBreakerInfo br;
+    bus.get_breaker(DEV_ADDR, &br);
+    bool quarantined = br.state != I2CBreakerState::CLOSED;
+    sim.clear_faults();
+    bus.reset_breaker(DEV_ADDR);
+
+    uint32_t attempts = bs1.failures - bs0.failures;
+    uint32_t soft = rs1.tier[(int)I2CRecoveryTier::DEVICE_SOFT].attempts -
+                    rs0.tier[(int)I2CRecoveryTier::DEVICE_SOFT].attempts;
+    uint32_t ladders = rs1.tier[(int)I2CRecoveryTier::BUS_CLEAR].attempts -
+                       rs0.tier[(int)I2CRecoveryTier::BUS_CLEAR].attempts;
+    bool ok = err != ESP_OK && attempts == want.attempts && soft == want.soft &&
+              ladders == want.ladders && quarantined == want.quarantined;
+    if (!ok) failed_rows++;
+
+    printf("%-26s attempts %lu/%lu  soft %lu/%lu  ladder %lu/%lu  quarantined %d/%d  %s\n", name,
+           (unsigned long)attempts, (unsigned long)want.attempts, (unsigned long)soft,
+           (unsigned long)want.soft, (unsigned long)ladders, (unsigned long)want.ladders,
+           quarantined, want.quarantined, ok ? "PASS" : "FAIL");
+}
+
+extern "C" void app_main() {
+    esp_log_level_set("ed_i2c", ESP_LOG_NONE);
+
+    I2CSimBackend sim;
+    sim.attach(DEV_ADDR);
+    I2CBus bus(sim, I2C_FREQ);
+
+    uint32_t restores = 0;
+    bus.register_recovery_callback(DEV_ADDR, [&restores]() { restores++; return ESP_OK; });
+
+    printf("\n--- Retry policies against a device that NACKs (measured/expected) ---\n");
+    // 3 attempts: soft recovery after the first, the ladder before the last
+    check<I2CRetryDefault>(bus, sim, "I2CRetryDefault", {3, 1, 1, true});
+    // 5 attempts, soft limit 2: soft, soft, ladder on the 3rd failure, ladder before the last
+    check<I2CBoundedRetry<5, 2>>(bus, sim, "I2CBoundedRetry<5, 2>", {5, 2, 2, true});
+    // One attempt, nothing else, and the device is not quarantined
+    check<I2CNoRetry>(bus, sim, "I2CNoRetry", {1, 0, 0, false});
+    // As the default, with a pause before the 2nd and 3rd attempts
+    check<I2CBackoffRetry<3, 2, 8>>(bus, sim, "I2CBackoffRetry<3, 2, 8>", {3, 1, 1, true});
+    // The ladder after every failure that another attempt follows
+    check<I2CEscalateRetry<3>>(bus, sim, "I2CEscalateRetry<3>", {3, 0, 2, true});
+
+    printf("recovery callback runs: %lu\n", (unsigned long)restores);
+    if (failed_rows) ESP_LOGE(TAG, "%d policies did not behave as documented", failed_rows);
+    else             ESP_LOGI(TAG, "all policies behave as documented");
+
+    while (true) vTaskDelay(pdMS_TO_TICKS(1000));
+}
@@ -0,0 +1,109 @@
+/**
+* @file I2C_trace_replay.cpp
+* @brief Records a bus session with a transaction trace, dumps it in the
+* binary format and replays it on a second simulator. Builds for the chip and
+* for the IDF linux target.
+*
+* The light sensor NACKs twice and SDA gets stuck once, so the trace shows
+* the retries, the quarantine and the recovery tiers between the regular
+* reads. The dump goes into a RAM buffer here; on a field unit the sink would
+* write to a file, UART or socket, and the replay would run on the host build.
+ *
+ * @author Emanuele Dolis (emanuele.dolis@gmail.com)
+ * @date 2026-07-22
+ */
+
+#include <cstdio>
+#include <cstring>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "ED_i2c.h"
+#include "ED_i2c_sim.h"
+#include "ED_i2c_trace.h"
+
+#define I2C_FREQ       400000
+#define IMU_ADDR       0x68
+#define LIGHT_ADDR     0x44
+#define TRACE_RECORDS  128
+
+static const char *TAG = "i2c_trace";
+
+static I2CTraceRecord trace_buf[TRACE_RECORDS];
+static uint8_t dump_buf[sizeof(I2CTraceHeader) + sizeof(trace_buf)];
+
+struct MemSink {
+    uint8_t *buf;
+    size_t   size;
+    size_t   used;
+};
+
+static esp_err_t mem_sink(const void *data, size_t len, void *arg) {
+    MemSink *m = static_cast<MemSink *>(arg);
+    if (m->used + len > m->size) return ESP_ERR_NO_MEM;
+    memcpy(m->buf + m->used, data, len);
+    m->used += len;
+    return ESP_OK;
+}
+
+static void read_sensors(I2CBus &bus, int rounds) {
+    uint8_t reg = 0x3B, imu[6], lux[2];
+    for (int i = 0; i < rounds; i++) {
+        bus.write_then_read(IMU_ADDR, &reg, 1, imu, sizeof(imu));
+        uint8_t lreg = 0x00;
+        bus.write_then_read(LIGHT_ADDR, &lreg, 1, lux, sizeof(lux));
+    }
+}
+
+extern "C" void app_main() {
+    // --- Field session ------------------------------------------------
+    I2CSimBackend sim;
+    I2CSimDevice *imu = sim.attach(IMU_ADDR);
+    sim.attach(LIGHT_ADDR);
+    for (int i = 0; i < 6; i++) imu->regs[0x3B + i] = (uint8_t)(0x10 * i);
+    I2CBus bus(sim, I2C_FREQ);
+
+    I2CTrace trace(trace_buf, TRACE_RECORDS);
+    ESP_ERROR_CHECK(bus.attach_trace(&trace));
+
+    read_sensors(bus, 3);
+    sim.inject({I2CSimFaultKind::NACK, LIGHT_ADDR, 0, 2, I2CRecoveryTier::BUS_CLEAR});
+    read_sensors(bus, 2);
+    sim.inject({I2CSimFaultKind::STUCK_SDA, IMU_ADDR, 0, 0, I2CRecoveryTier::DRIVER_REINIT});
+    read_sensors(bus, 2);
+    vTaskDelay(pdMS_TO_TICKS(500));   // the breaker's probe task runs the recovery ladder
+    read_sensors(bus, 1);
+
+    trace.log();
+
+    // --- Dump -----------------------------------------------------------
+    MemSink sink = {dump_buf, sizeof(dump_buf), 0};
+    ESP_ERROR_CHECK(trace.dump(mem_sink, &sink));
+    I2CTraceHeader hdr;
+    memcpy(&hdr, dump_buf, sizeof(hdr));
+    ESP_LOGI(TAG, "dump: %u bytes, %lu records, %lu lost", (unsigned)sink.used, (unsigned long)hdr.count,
+             (unsigned long)hdr.lost);
+
+    // --- Offline replay -------------------------------------------------
+    if (hdr.magic != I2C_TRACE_MAGIC || hdr.record_size != sizeof(I2CTraceRecord)) {
+        ESP_LOGE(TAG, "not a trace dump");
+        return;
+    }
+    static I2CTraceRecord recs[TRACE_RECORDS];
+    memcpy(recs, dump_buf + sizeof(hdr), hdr.count * sizeof(I2CTraceRecord));
+
+    I2CSimBackend lab;   // devices are attached by the replay
+    I2CTraceReplayStats st;
+    ESP_ERROR_CHECK(I2CTrace::replay(recs, hdr.count, lab, I2C_FREQ, &st));
+    I2CSimStats lab_st;
+    lab.get_stats(&lab_st);
+    printf("\nreplayed %lu operations, %lu mismatches\n", (unsigned long)st.operations,
+           (unsigned long)st.mismatches);
+    printf("recorded %llu us, modelled %llu us; %lu nacks, %lu timeouts\n",
+           (unsigned long long)st.recorded_us, (unsigned long long)st.modelled_us,
+           (unsigned long)lab_st.nacks, (unsigned long)lab_st.timeouts);
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
@@ -0,0 +1,106 @@
+/**
+* @file SNTP_batch_bench.cpp
+* @brief Converting a buffer of esp_timer timestamps at upload time: one
+* TimeSync call per sample against the batch API.
+*
+* Once the clock is synced, a buffer of increasing timestamps, as a sensor
+* logger would have stored them, is converted four ways: getClockTime() per
+* sample and formatClockTimes() into packed strings, getEpochTime_us() per
+* sample and getEpochTimes(). The benchmark reports samples per second for
+* each and checks that both paths give the same result. Needs WiFi for the
+* initial sync.
+ *
+ * @author Emanuele Dolis (emanuele.dolis@gmail.com)
+ * @date 2026-08-24
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "ED_SNTP_time.h"
+#include "ED_wifi.h"
+
+#define SAMPLES      2000
+#define ROUNDS       5
+#define SAMPLE_GAP   4000    // µs between stored samples, 250 Hz
+#define STR_STRIDE   26      // "2025-08-25T14:30:00+0200" + NUL + margin
+
+static const char *TAG = "sntp_batch";
+
+using namespace ED_SNTP;
+
+static uint64_t s_ticks[SAMPLES];
+static uint64_t s_epochs[SAMPLES];
+static char     s_text[SAMPLES * STR_STRIDE];
+
+static void report(const char *name, int64_t elapsed_us) {
+    ESP_LOGI(TAG, "%-28s: %9.0f samples/s  (%.2f us per sample)", name,
+             (double)SAMPLES * ROUNDS * 1e6 / elapsed_us, (double)elapsed_us / (SAMPLES * ROUNDS));
+}
+
+static void bench_task(void *arg) {
+    while (TimeSync::getEpochTime_us() == 0) vTaskDelay(pdMS_TO_TICKS(500));
+    ESP_LOGI(TAG, "Clock synced, %d samples x %d rounds", SAMPLES, ROUNDS);
+
+    uint64_t t = esp_timer_get_time();
+    for (int i = 0; i < SAMPLES; i++) s_ticks[i] = t - (uint64_t)(SAMPLES - i) * SAMPLE_GAP;
+
+    // --- formatted ---------------------------------------------------------
+    int64_t t0 = esp_timer_get_time();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) {
+            std::string s = TimeSync::getClockTime(s_ticks[i], TICKTYPE::TICK_US, ISOFORMAT::DATETIME_OFFSET);
+            memcpy(s_text + i * STR_STRIDE, s.c_str(), s.size() + 1);
+        }
+    report("getClockTime per sample", esp_timer_get_time() - t0);
+
+    t0 = esp_timer_get_time();
+    size_t n = 0;
+    for (int r = 0; r < ROUNDS; r++)
+        n = TimeSync::formatClockTimes(s_ticks, SAMPLES, TICKTYPE::TICK_US, ISOFORMAT::DATETIME_OFFSET,
+                                       s_text, sizeof(s_text));
+    report("formatClockTimes", esp_timer_get_time() - t0);
+
+    // The packed strings must match the per-sample ones
+    int mismatches = 0;
+    const char *p = s_text;
+    for (size_t i = 0; i < n; i++) {
+        if (TimeSync::getClockTime(s_ticks[i], TICKTYPE::TICK_US, ISOFORMAT::DATETIME_OFFSET) != p) mismatches++;
+        p += strlen(p) + 1;
+    }
+    ESP_LOGI(TAG, "%u/%d strings packed in %u bytes, %d mismatches, first %s", (unsigned)n, SAMPLES,
+             (unsigned)(p - s_text), mismatches, s_text);
+
+    // --- epoch -------------------------------------------------------------
+    t0 = esp_timer_get_time();
+    for (int r = 0; r < ROUNDS; r++)
+        for (int i = 0; i < SAMPLES; i++) s_epochs[i] = TimeSync::getEpochTime_us(s_ticks[i]);
+    report("getEpochTime_us per sample", esp_timer_get_time() - t0);
+
+    t0 = esp_timer_get_time();
+    for (int r = 0; r < ROUNDS; r++) TimeSync::getEpochTimes(s_ticks, s_epochs, SAMPLES, TICKTYPE::TICK_US);
+    report("getEpochTimes", esp_timer_get_time() - t0);
+
+    mismatches = 0;
+    for (int i = 0; i < SAMPLES; i++)
+        if (s_epochs[i] != TimeSync::getEpochTime_us(s_ticks[i])) mismatches++;
+    ESP_LOGI(TAG, "epoch batch: %d mismatches", mismatches);
+
+    vTaskDelete(NULL);
+}
+
+static void launchSNTP() {
+    TimeSync::initialize(NTPSERVER[0], TimeZone::CET);
+}
+
+extern "C" void app_main() {
+    ED_wifi::WiFiService::subscribeToIPReady(launchSNTP);
+    ED_wifi::WiFiService::launch();
+    xTaskCreate(bench_task, "batch_bench", 4096, NULL, 5, NULL);
+
+    while (1) vTaskDelay(pdMS_TO_TICKS(1000));
+}
@@ -0,0 +1,138 @@
+/**
+* @file SNTP_race_bench.cpp
+* @brief Time to first valid clock: servers tried one at a time, as the
+* SNTP client of TimeSync does, against all of them queried at once.
+*
+* Fake NTP servers run on the loopback interface, one task each: two never
+* answer, one answers at once but flags its clock as unsynchronized, one
+* answers after 150 ms and one after 20 ms. They serve a fixed date plus
+* esp_timer, so the error of the clock each method obtains is known. The
+* sequential run applies TimeSync's schedule (1000 ms timeout, +500 ms per
+* failed server). Needs no network, only CONFIG_LWIP_NETIF_LOOPBACK
+* (enabled by default).
+ *
+ * @author Emanuele Dolis (emanuele.dolis@gmail.com)
+ * @date 2026-08-29
+ */
+
+#include <cstdio>
+#include <cstring>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "ED_SNTP_race.h"
+
+#define FAKE_EPOCH_S     1787961600LL   // 2026-08-29T00:00:00Z
+#define NTP_UNIX_OFFSET  2208988800LL
+#define SEQ_TIMEOUT_MS   1000           // TimeSync's first timeout
+#define SEQ_TIMEOUT_STEP 500            // added per failed server
+#define RACE_TIMEOUT_MS  3000
+
+static const char *TAG = "sntp_race";
+
+using namespace ED_SNTP;
+
+enum class Fake { SILENT, UNSYNCED, SLOW, FAST };
+
+struct FakeServer {
+    uint16_t port;
+    Fake     kind;
+    uint32_t delay_ms;
+};
+
+static const FakeServer s_fakes[] = {
+    {12301, Fake::SILENT,   0},
+    {12302, Fake::SILENT,   0},
+    {12303, Fake::UNSYNCED, 0},
+    {12304, Fake::SLOW,     150},
+    {12305, Fake::FAST,     20},
+};
+static const char *s_names[] = {
+    "127.0.0.1:12301", "127.0.0.1:12302", "127.0.0.1:12303", "127.0.0.1:12304", "127.0.0.1:12305",
+};
+#define FAKES (sizeof(s_fakes) / sizeof(s_fakes[0]))
+
+// The fakes' clock: what a perfect sync would give
+static int64_t fake_now_us() { return FAKE_EPOCH_S * 1000000 + esp_timer_get_time(); }
+
+static void put_ts(uint8_t *p, int64_t unix_us) {
+    uint64_t v = ((uint64_t)(unix_us / 1000000 + NTP_UNIX_OFFSET) << 32) |
+                 (((uint64_t)(unix_us % 1000000) << 32) / 1000000);
+    for (int i = 7; i >= 0; i--, v >>= 8) p[i] = (uint8_t)v;
+}
+
+static void fake_server_task(void *arg) {
+    const FakeServer *f = (const FakeServer *)arg;
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(f->port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (sock < 0 || bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        ESP_LOGE(TAG, "fake server %u: bind failed", f->port);
+        vTaskDelete(NULL);
+    }
+
+    uint8_t pkt[48];
+    while (1) {
+        struct sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        if (recvfrom(sock, pkt, sizeof(pkt), 0, (struct sockaddr *)&from, &fromLen) != sizeof(pkt)) continue;
+        if (f->kind == Fake::SILENT) continue;
+        vTaskDelay(pdMS_TO_TICKS(f->delay_ms / 2));   // path delay, half each way
+        int64_t rx = fake_now_us();
+        vTaskDelay(pdMS_TO_TICKS(f->delay_ms / 2));
+        uint8_t reply[48] = {};
+        reply[0] = (uint8_t)(((f->kind == Fake::UNSYNCED ? 3 : 0) << 6) | (4 << 3) | 4);   // LI, VN 4, server
+        reply[1] = 2;                                                                      // stratum
+        memcpy(reply + 24, pkt + 40, 8);                                                   // originate = their transmit
+        put_ts(reply + 32, rx);
+        put_ts(reply + 40, rx);
+        sendto(sock, reply, sizeof(reply), 0, (struct sockaddr *)&from, fromLen);
+    }
+}
+
+static void report(const char *name, esp_err_t err, int64_t elapsed_us, const NtpReply &r) {
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "%-18s: no clock (%s) after %lld ms", name, esp_err_to_name(err), (long long)(elapsed_us / 1000));
+        return;
+    }
+    ESP_LOGI(TAG, "%-18s: valid clock after %6lld ms from %s, rtt %lu us, error %+lld us", name,
+             (long long)(elapsed_us / 1000), s_names[r.server], (unsigned long)r.rtt_us,
+             (long long)(r.unixTime_us - (FAKE_EPOCH_S * 1000000 + (int64_t)r.rtc_us)));
+}
+
+static void run_sequential() {
+    int64_t t0 = esp_timer_get_time();
+    uint32_t timeout = SEQ_TIMEOUT_MS;
+    NtpReply r = {};
+    esp_err_t err = ESP_ERR_TIMEOUT;
+    for (size_t i = 0; i < FAKES && err != ESP_OK; i++, timeout += SEQ_TIMEOUT_STEP) {
+        err = ntpRace(&s_names[i], 1, RacePolicy::FIRST_VALID, timeout, &r);
+        if (err == ESP_OK) r.server = (int8_t)i;
+    }
+    report("sequential", err, esp_timer_get_time() - t0, r);
+}
+
+static void run_race(const char *name, RacePolicy policy) {
+    NtpReply r;
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t err = ntpRace(s_names, FAKES, policy, RACE_TIMEOUT_MS, &r);
+    report(name, err, esp_timer_get_time() - t0, r);
+}
+
+extern "C" void app_main() {
+    ESP_ERROR_CHECK(esp_netif_init());
+    for (size_t i = 0; i < FAKES; i++)
+        xTaskCreate(fake_server_task, "fake_ntp", 3072, (void *)&s_fakes[i], 6, NULL);
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    run_sequential();
+    run_race("race, first valid", RacePolicy::FIRST_VALID);
+    run_race("race, best rtt", RacePolicy::BEST_RTT);
+
+    while (1) vTaskDelay(pdMS_TO_TICKS(1000));
+}
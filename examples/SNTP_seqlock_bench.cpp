@@ -0,0 +1,173 @@
+/**
+* @file SNTP_seqlock_bench.cpp
+* @brief Clock reference reads: portMUX critical section (the former
+* TimeSync path) vs the seqlock TimeSync uses now, with concurrent readers.
+*
+* Four reader tasks, two per core, read a {unix time, RTC, valid} reference
+* as fast as they can while a writer republishes it every tick, far more
+* often than SNTP would. For each path the benchmark reports reads per
+* second, the slowest single read, torn reads (must be 0) and the worst
+* lateness of a 1 kHz esp_timer callback, which shows the time interrupts
+* spent masked or waiting behind the readers. No network needed.
+ *
+ * @author Emanuele Dolis (emanuele.dolis@gmail.com)
+ * @date 2026-08-10
+ */
+
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "ED_seqlock.h"
+
+#define READERS          4
+#define RUN_MS           2000
+#define PROBE_PERIOD_US  1000
+
+static const char *TAG = "sntp_bench";
+
+struct ClockRef {
+    int64_t  unixTime;
+    uint64_t rtc_us;
+    bool     valid;
+};
+
+// Writer keeps rtc_us = unixTime * 1000003: any other pair is a torn read
+static ClockRef make_ref(int64_t n) { return {n, (uint64_t)n * 1000003ULL, true}; }
+static bool consistent(const ClockRef &r) { return r.rtc_us == (uint64_t)r.unixTime * 1000003ULL; }
+
+// ---- former path: plain fields under a spinlock ----
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static ClockRef     s_muxRef;
+
+static ClockRef __attribute__((noinline)) mux_read() {
+    portENTER_CRITICAL(&s_mux);
+    ClockRef r = s_muxRef;
+    portEXIT_CRITICAL(&s_mux);
+    return r;
+}
+
+static void mux_write(const ClockRef &r) {
+    portENTER_CRITICAL(&s_mux);
+    s_muxRef = r;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+// ---- seqlock path, written under the spinlock as TimeSync does ----
+static SeqLock<ClockRef> s_seqRef;
+
+static ClockRef __attribute__((noinline)) seq_read() {
+    ClockRef r;
+    s_seqRef.load(&r);
+    return r;
+}
+
+static void seq_write(const ClockRef &r) {
+    portENTER_CRITICAL(&s_mux);
+    s_seqRef.store(r);
+    portEXIT_CRITICAL(&s_mux);
+}
+
+// ---- harness ----
+struct Run {
+    ClockRef (*read)();
+    void (*write)(const ClockRef &);
+    std::atomic<bool>     stop;
+    std::atomic<int>      running;
+    uint32_t              reads[READERS];
+    uint32_t              torn[READERS];
+    uint32_t              max_cycles[READERS];
+    std::atomic<int64_t>  probe_max_late_us;
+    int64_t               probe_next_us;
+};
+
+static Run s_run;
+
+static void reader_task(void *arg) {
+    int id = (int)(intptr_t)arg;
+    uint32_t n = 0, torn = 0, worst = 0;
+    while (!s_run.stop.load(std::memory_order_relaxed)) {
+        esp_cpu_cycle_count_t c0 = esp_cpu_get_cycle_count();
+        ClockRef r = s_run.read();
+        uint32_t c = (uint32_t)(esp_cpu_get_cycle_count() - c0);
+        if (c > worst) worst = c;
+        if (!consistent(r)) torn++;
+        n++;
+    }
+    s_run.reads[id] = n;
+    s_run.torn[id] = torn;
+    s_run.max_cycles[id] = worst;
+    s_run.running--;
+    vTaskDelete(NULL);
+}
+
+static void writer_task(void *arg) {
+    int64_t k = 1;
+    while (!s_run.stop.load(std::memory_order_relaxed)) {
+        s_run.write(make_ref(k++));
+        vTaskDelay(1);
+    }
+    s_run.running--;
+    vTaskDelete(NULL);
+}
+
+static void probe_cb(void *arg) {
+    int64_t now = esp_timer_get_time();
+    int64_t late = now - s_run.probe_next_us;
+    if (late > s_run.probe_max_late_us.load(std::memory_order_relaxed))
+        s_run.probe_max_late_us.store(late, std::memory_order_relaxed);
+    s_run.probe_next_us += PROBE_PERIOD_US;
+    if (s_run.probe_next_us < now) s_run.probe_next_us = now + PROBE_PERIOD_US;   // missed periods
+}
+
+static void bench(const char *name, ClockRef (*read)(), void (*write)(const ClockRef &)) {
+    s_run.read = read;
+    s_run.write = write;
+    s_run.stop = false;
+    s_run.running = READERS + 1;
+    s_run.probe_max_late_us = 0;
+    write(make_ref(0));
+
+    esp_timer_handle_t probe;
+    esp_timer_create_args_t args = {};
+    args.callback = probe_cb;
+    args.name = "latency_probe";
+    ESP_ERROR_CHECK(esp_timer_create(&args, &probe));
+    s_run.probe_next_us = esp_timer_get_time() + PROBE_PERIOD_US;
+    ESP_ERROR_CHECK(esp_timer_start_periodic(probe, PROBE_PERIOD_US));
+
+    xTaskCreatePinnedToCore(writer_task, "writer", 2048, NULL, 6, NULL, 0);
+    for (int i = 0; i < READERS; i++)
+        xTaskCreatePinnedToCore(reader_task, "reader", 2048, (void *)(intptr_t)i, 5, NULL,
+                                portNUM_PROCESSORS > 1 ? i % 2 : 0);
+    vTaskDelay(pdMS_TO_TICKS(RUN_MS));
+    s_run.stop = true;
+    while (s_run.running > 0) vTaskDelay(1);
+    esp_timer_stop(probe);
+    esp_timer_delete(probe);
+
+    uint64_t reads = 0;
+    uint32_t torn = 0, worst = 0;
+    for (int i = 0; i < READERS; i++) {
+        reads += s_run.reads[i];
+        torn += s_run.torn[i];
+        if (s_run.max_cycles[i] > worst) worst = s_run.max_cycles[i];
+    }
+    ESP_LOGI(TAG, "%-8s: %8.0f reads/s, slowest read %5lu cycles, %lu torn, timer late by %lld us at most",
+             name, reads * 1000.0 / RUN_MS, (unsigned long)worst, (unsigned long)torn,
+             (long long)s_run.probe_max_late_us.load());
+}
+
+extern "C" void app_main() {
+    vTaskPrioritySet(NULL, 10);   // above the readers, which never block
+    ESP_LOGI(TAG, "%d readers on %d core(s), writer every tick, %d ms per run", READERS,
+             portNUM_PROCESSORS, RUN_MS);
+    bench("portMUX", mux_read, mux_write);
+    bench("seqlock", seq_read, seq_write);
+
+    while (1) vTaskDelay(pdMS_TO_TICKS(1000));
+}
@@ -36,6 +36,7 @@ struct GIT_fwInfo {
 #include "ED_SNTP_time.h"
 #include "ED_sysInfo.h"
 #include "ED_wifi.h"
+#include "nvs_flash.h"
 // #include "esp_partition.h"
 #include <string.h>
 
@@ -74,6 +75,14 @@ extern "C" void app_main(void) {
   }
 #endif
 
+  // NVS keeps the SNTP server ranking across reboots
+  esp_err_t err = nvs_flash_init();
+  if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+    ESP_ERROR_CHECK(nvs_flash_erase());
+    err = nvs_flash_init();
+  }
+  ESP_ERROR_CHECK(err);
+
   ED_wifi::WiFiService::subscribeToIPReady(launchSNTPalignment);
   ED_wifi::WiFiService::launch();
 